@@ -0,0 +1,213 @@
+#include <pthread.h>
+#include <errno.h>
+#include "bases.h"
+#include "asynchrone.h"
+
+/*
+ * Les tampons pleins forment une file circulaire "pleins"
+ * (avec leurs longueurs), les tampons libres une pile "libres".
+ * Tout est protégé par "verrou" sauf le contenu des tampons :
+ * un tampon n'appartient qu'à un seul fil d'exécution à la fois.
+ */
+
+struct asynchrone
+{
+  int             fd ;
+  int             nb_tampons ;
+  unsigned char **pleins ;
+  size_t         *longueurs ;
+  int             premier ;		/* Premier tampon plein */
+  int             nb_pleins ;
+  unsigned char **libres ;
+  int             nb_libres ;
+  int             fin ;			/* Plus rien ne sera donné */
+  int             erreur ;		/* Une écriture a échoué */
+  pthread_t       ecrivain ;
+  pthread_mutex_t verrou ;
+  pthread_cond_t  tampon_plein ;
+  pthread_cond_t  tampon_libre ;
+} ;
+
+/*
+ * Ecrit complètement les "nb" octets, même si "write" n'en
+ * écrit qu'une partie (tube plein) ou est interrompu.
+ * Retourne 0 si tout va bien.
+ */
+
+static int ecrit_tout(int fd, const unsigned char *t, size_t nb)
+{
+  ssize_t n ;
+
+  while( nb )
+    {
+      n = write(fd, t, nb) ;
+      if ( n < 0 )
+	{
+	  if ( errno == EINTR )
+	    continue ;
+	  return -1 ;
+	}
+      t += n ;
+      nb -= n ;
+    }
+  return 0 ;
+}
+
+/*
+ * Le fil d'exécution qui écrit les tampons pleins.
+ * Après une erreur, il continue à libérer les tampons sans les écrire
+ * pour que le programme ne reste pas bloqué.
+ */
+
+static void *ecrivain(void *arg)
+{
+  struct asynchrone *a = arg ;
+  unsigned char *t ;
+  size_t nb ;
+  int erreur ;
+
+  pthread_mutex_lock(&a->verrou) ;
+  for(;;)
+    {
+      while( a->nb_pleins == 0 && !a->fin )
+	pthread_cond_wait(&a->tampon_plein, &a->verrou) ;
+      if ( a->nb_pleins == 0 )
+	break ;
+      t = a->pleins[a->premier] ;
+      nb = a->longueurs[a->premier] ;
+      erreur = a->erreur ;
+      pthread_mutex_unlock(&a->verrou) ;
+
+      if ( !erreur && ecrit_tout(a->fd, t, nb) )
+	erreur = 1 ;
+
+      pthread_mutex_lock(&a->verrou) ;
+      a->erreur = erreur ;
+      a->premier = (a->premier + 1) % a->nb_tampons ;
+      a->nb_pleins-- ;
+      a->libres[a->nb_libres++] = t ;
+      pthread_cond_signal(&a->tampon_libre) ;
+    }
+  pthread_mutex_unlock(&a->verrou) ;
+  return NULL ;
+}
+
+/*
+ * Allocation des tampons et lancement de l'écrivain.
+ * Il faut au moins 2 tampons pour que l'écriture et le remplissage
+ * puissent se faire en même temps.
+ */
+
+struct asynchrone *open_asynchrone(int fd, int nb_tampons, size_t taille)
+{
+  struct asynchrone *a ;
+  int i ;
+
+  ALLOUER(a, 1) ;
+  a->fd = fd ;
+  a->nb_tampons = MAX(nb_tampons, 2) ;
+  ALLOUER(a->pleins, a->nb_tampons) ;
+  ALLOUER(a->longueurs, a->nb_tampons) ;
+  ALLOUER(a->libres, a->nb_tampons) ;
+  for(i=0; i<a->nb_tampons; i++)
+    ALLOUER(a->libres[i], taille) ;
+  a->nb_libres = a->nb_tampons ;
+  a->premier = 0 ;
+  a->nb_pleins = 0 ;
+  a->fin = 0 ;
+  a->erreur = 0 ;
+  pthread_mutex_init(&a->verrou, NULL) ;
+  pthread_cond_init(&a->tampon_plein, NULL) ;
+  pthread_cond_init(&a->tampon_libre, NULL) ;
+  if ( pthread_create(&a->ecrivain, NULL, ecrivain, a) != 0 )
+    EXIT ;
+  return a ;
+}
+
+/*
+ * Met le tampon dans la file de l'écrivain, ou directement dans
+ * les tampons libres s'il est vide. Le verrou doit être pris.
+ */
+
+static void donne(struct asynchrone *a, unsigned char *plein, size_t nb)
+{
+  int i ;
+
+  if ( plein == NULL )
+    return ;
+  if ( nb == 0 )
+    {
+      a->libres[a->nb_libres++] = plein ;
+      return ;
+    }
+  i = (a->premier + a->nb_pleins) % a->nb_tampons ;
+  a->pleins[i] = plein ;
+  a->longueurs[i] = nb ;
+  a->nb_pleins++ ;
+  pthread_cond_signal(&a->tampon_plein) ;
+}
+
+/*
+ * Donne à l'écrivain les "nb" premiers octets de "plein"
+ * et retourne un tampon libre.
+ * On attend si tous les tampons sont en cours d'écriture.
+ * Le premier appel se fait avec "plein" à NULL.
+ */
+
+unsigned char *asynchrone_echange(struct asynchrone *a, unsigned char *plein
+				  , size_t nb)
+{
+  unsigned char *t ;
+
+  pthread_mutex_lock(&a->verrou) ;
+  donne(a, plein, nb) ;
+  while( a->nb_libres == 0 )
+    pthread_cond_wait(&a->tampon_libre, &a->verrou) ;
+  t = a->libres[--a->nb_libres] ;
+  pthread_mutex_unlock(&a->verrou) ;
+  return t ;
+}
+
+/*
+ * Retourne vrai si une écriture a déjà échoué.
+ */
+
+int asynchrone_erreur(struct asynchrone *a)
+{
+  int erreur ;
+
+  pthread_mutex_lock(&a->verrou) ;
+  erreur = a->erreur ;
+  pthread_mutex_unlock(&a->verrou) ;
+  return erreur ;
+}
+
+/*
+ * Donne le dernier tampon, attend la fin des écritures
+ * et libère tout.
+ * Retourne vrai si une écriture a échoué.
+ */
+
+int close_asynchrone(struct asynchrone *a, unsigned char *plein, size_t nb)
+{
+  int erreur, i ;
+
+  pthread_mutex_lock(&a->verrou) ;
+  donne(a, plein, nb) ;
+  a->fin = 1 ;
+  pthread_cond_signal(&a->tampon_plein) ;
+  pthread_mutex_unlock(&a->verrou) ;
+  pthread_join(a->ecrivain, NULL) ;
+
+  erreur = a->erreur ;
+  for(i=0; i<a->nb_libres; i++)
+    free(a->libres[i]) ;
+  free(a->libres) ;
+  free(a->pleins) ;
+  free(a->longueurs) ;
+  pthread_mutex_destroy(&a->verrou) ;
+  pthread_cond_destroy(&a->tampon_plein) ;
+  pthread_cond_destroy(&a->tampon_libre) ;
+  free(a) ;
+  return erreur ;
+}
@@ -0,0 +1,22 @@
+#ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_ASYNCHRONE_H
+#define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_ASYNCHRONE_H
+
+#include <stddef.h>
+
+/*
+ * Ecriture en tâche de fond dans un descripteur de fichier.
+ *
+ * On dispose de "nb_tampons" tampons de "taille" octets.
+ * Le programme remplit un tampon et l'échange contre un tampon libre
+ * pendant qu'un fil d'exécution (thread) écrit les tampons pleins
+ * dans l'ordre où ils ont été donnés.
+ */
+
+struct asynchrone ;
+
+struct asynchrone *open_asynchrone(int fd, int nb_tampons, size_t taille) ;
+unsigned char     *asynchrone_echange(struct asynchrone *a, unsigned char *plein, size_t nb) ;
+int                asynchrone_erreur(struct asynchrone *a) ;
+int                close_asynchrone(struct asynchrone *a, unsigned char *plein, size_t nb) ;
+
+#endif
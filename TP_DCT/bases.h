@@ -36,6 +36,15 @@
 #define CONCATENE(A,B) A ## B
 
 
+/*
+ * Processeur x86 (32 ou 64 bits) : "vecteur.c", "bit.c" et "crc.c"
+ * y compilent aussi des versions utilisant les extensions du jeu
+ * d'instructions (attribut "target"), choisies à l'exécution.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define PROCESSEUR_X86
+#endif
+
 #ifndef ABS
 #define ABS(A) ( (A)>=0 ? (A) : -(A) )
 #endif
@@ -44,6 +53,10 @@
 #define MAX(A,B) ( (A)>=(B) ? (A) : (B) )
 #endif
 
+#ifndef MIN
+#define MIN(A,B) ( (A)<=(B) ? (A) : (B) )
+#endif
+
 /*
  * "printf" sur "stderr" au lieu de "stdout"
  * NE L'UTILISEZ PAS pour debugger cela perturberait les tests
@@ -1,5 +1,13 @@
+#include <pthread.h>
+#include "bases.h"
 #include "bit.h"
 
+#ifdef PROCESSEUR_X86
+#include <immintrin.h>
+#endif
+
+#define NB_BITS_LONG (8 * sizeof(unsigned long))
+
 /*
  * Retourne le nombre de bits utilisé pour coder l'entier
  * Voici quelques chiffres :
@@ -15,12 +23,7 @@
 
 unsigned int nb_bits_utile(unsigned long v)
 {
-		unsigned int i = 0;
-	   	while (v>>=i != 0)
-	   	{
-				i++;
-	   	}
-	    	return i;
+  return NB_BITS_LONG - nb_zeros_gauche(v) ;
 }
 
 /*
@@ -81,3 +84,272 @@ unsigned long pose_bit(unsigned long c,	      /* Entier à modifier */
 	return c & ~pow2(position);
 
 }
+
+/*
+ * Nombre de bits à 0 à gauche du premier bit à 1.
+ * Pour v=0 c'est le nombre de bits d'un "unsigned long".
+ *
+ * "__builtin_clzl" est une seule instruction (BSR ou LZCNT suivant
+ * les options de compilation), mais elle n'est pas définie pour 0.
+ */
+
+unsigned int nb_zeros_gauche(unsigned long v)
+{
+  return v ? __builtin_clzl(v) : NB_BITS_LONG ;
+}
+
+/*
+ * Les fonctions suivantes existent en deux versions :
+ *    - Une version portable.
+ *    - Une version qui utilise les instructions LZCNT (définie pour 0,
+ *      contrairement à BSR) et BMI2 (PEXT/PDEP) des processeurs
+ *      x86 récents.
+ *    - Pour "nb_bits_utile_tableau", une version AVX2.
+ * La version est choisie à la première utilisation suivant le processeur,
+ * le compilateur génère les instructions grâce à l'attribut "target".
+ *
+ * Attention : sur les AMD antérieurs à Zen 3 PDEP/PEXT sont microcodées
+ * et plus lentes que la version portable : elles sont utilisées
+ * pour "extrait_bits" et "depose_bits" mais "extrait_depose_rapides"
+ * répond non.
+ */
+
+static void nb_bits_utile_tableau_base(const unsigned int *v
+				       , Position_Bit *nb, size_t n)
+{
+  size_t i ;
+
+  for(i=0; i<n; i++)
+    nb[i] = v[i] ? 32 - __builtin_clz(v[i]) : 0 ;
+}
+
+/*
+ * Range dans les bits de droite du résultat les bits de "v"
+ * qui sont à 1 dans "masque" (de droite à gauche).
+ */
+static unsigned long extrait_bits_base(unsigned long v, unsigned long masque)
+{
+  unsigned long r, b ;
+
+  r = 0 ;
+  for(b = 1 ; masque ; b <<= 1)
+    {
+      if ( v & masque & -masque )
+	r |= b ;
+      masque &= masque - 1 ;		/* Enlève le bit de droite */
+    }
+  return r ;
+}
+
+/*
+ * Fait l'inverse : les bits de droite de "v" sont posés
+ * aux positions des bits à 1 de "masque".
+ */
+static unsigned long depose_bits_base(unsigned long v, unsigned long masque)
+{
+  unsigned long r, b ;
+
+  r = 0 ;
+  for(b = 1 ; masque ; b <<= 1)
+    {
+      if ( v & b )
+	r |= masque & -masque ;
+      masque &= masque - 1 ;
+    }
+  return r ;
+}
+
+#ifdef PROCESSEUR_X86
+
+__attribute__((target("lzcnt")))
+static void nb_bits_utile_tableau_lzcnt(const unsigned int *v
+					, Position_Bit *nb, size_t n)
+{
+  size_t i ;
+
+  for(i=0; i<n; i++)
+    nb[i] = 32 - _lzcnt_u32(v[i]) ;	/* LZCNT est défini pour 0 */
+}
+
+/*
+ * 8 entiers à la fois. On met à 1 tous les bits sous le premier 1,
+ * puis on ne garde que le premier 1 : cette puissance de 2 est exacte
+ * en flottant et son exposant donne le nombre de bits (LZCNT n'existe
+ * pas en AVX2). 2^31 est converti en -2^31, de même exposant.
+ */
+__attribute__((target("avx2")))
+static void nb_bits_utile_tableau_avx2(const unsigned int *v
+				       , Position_Bit *nb, size_t n)
+{
+  const __m256i octets = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1
+					  , -1, -1, -1, -1, -1, -1, -1, -1
+					  , 0, 4, 8, 12, -1, -1, -1, -1
+					  , -1, -1, -1, -1, -1, -1, -1, -1) ;
+  __m256i x ;
+  size_t i ;
+
+  for(i=0; i+8 <= n; i+=8)
+    {
+      x = _mm256_loadu_si256((const __m256i*)(v + i)) ;
+      x = _mm256_or_si256(x, _mm256_srli_epi32(x, 1)) ;
+      x = _mm256_or_si256(x, _mm256_srli_epi32(x, 2)) ;
+      x = _mm256_or_si256(x, _mm256_srli_epi32(x, 4)) ;
+      x = _mm256_or_si256(x, _mm256_srli_epi32(x, 8)) ;
+      x = _mm256_or_si256(x, _mm256_srli_epi32(x, 16)) ;
+      x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 1)) ;
+      x = _mm256_castps_si256(_mm256_cvtepi32_ps(x)) ;
+      x = _mm256_and_si256(_mm256_srli_epi32(x, 23), _mm256_set1_epi32(0xFF)) ;
+      /* Exposant de 1 : 127 ; 0 donne 0 */
+      x = _mm256_max_epi32(_mm256_sub_epi32(x, _mm256_set1_epi32(126))
+			   , _mm256_setzero_si256()) ;
+      x = _mm256_shuffle_epi8(x, octets) ; /* Un octet par entier */
+      _mm_storel_epi64((__m128i*)(nb + i)
+		       , _mm_unpacklo_epi32(_mm256_castsi256_si128(x)
+					    , _mm256_extracti128_si256(x, 1))) ;
+    }
+  nb_bits_utile_tableau_base(v + i, nb + i, n - i) ;
+}
+
+#ifdef __x86_64__
+#define PEXT _pext_u64
+#define PDEP _pdep_u64
+#else
+#define PEXT _pext_u32
+#define PDEP _pdep_u32
+#endif
+
+__attribute__((target("bmi2")))
+static unsigned long extrait_bits_bmi2(unsigned long v, unsigned long masque)
+{
+  return PEXT(v, masque) ;
+}
+
+__attribute__((target("bmi2")))
+static unsigned long depose_bits_bmi2(unsigned long v, unsigned long masque)
+{
+  return PDEP(v, masque) ;
+}
+
+#endif
+
+static struct
+{
+  void (*nb_bits_utile_tableau)(const unsigned int *, Position_Bit *, size_t);
+  unsigned long (*extrait_bits)(unsigned long, unsigned long) ;
+  unsigned long (*depose_bits)(unsigned long, unsigned long) ;
+  Booleen rapides ;			/* PEXT/PDEP en un cycle */
+} version ;
+static pthread_once_t version_choisie = PTHREAD_ONCE_INIT ;
+
+static void choisit_base(void)
+{
+  version.nb_bits_utile_tableau = nb_bits_utile_tableau_base ;
+  version.extrait_bits = extrait_bits_base ;
+  version.depose_bits = depose_bits_base ;
+  version.rapides = Faux ;
+}
+
+/*
+ * Pour NULL chaque fonction prend la meilleure version disponible,
+ * pour "x86" il faut que le processeur ait LZCNT et BMI2,
+ * pour "avx2" il faut en plus AVX2 ("nb_bits_utile_tableau" en SIMD).
+ */
+
+static int choisit(const char *nom)
+{
+#ifdef PROCESSEUR_X86
+  int lzcnt, bmi2, avx2, x86 ;
+
+  __builtin_cpu_init() ;
+  lzcnt = __builtin_cpu_supports("abm") || __builtin_cpu_supports("lzcnt") ;
+  bmi2 = __builtin_cpu_supports("bmi2") ;
+  avx2 = __builtin_cpu_supports("avx2") ;
+  x86 = nom != NULL && strcmp(nom, "x86") == 0 ;
+  if ( nom == NULL || (x86 && lzcnt && bmi2)
+       || (strcmp(nom, "avx2") == 0 && lzcnt && bmi2 && avx2) )
+    {
+      choisit_base() ;
+      if ( lzcnt )
+	version.nb_bits_utile_tableau = nb_bits_utile_tableau_lzcnt ;
+      if ( avx2 && !x86 )
+	version.nb_bits_utile_tableau = nb_bits_utile_tableau_avx2 ;
+      if ( bmi2 )
+	{
+	  version.extrait_bits = extrait_bits_bmi2 ;
+	  version.depose_bits = depose_bits_bmi2 ;
+	  version.rapides = nom != NULL
+	    || !(__builtin_cpu_is("znver1") || __builtin_cpu_is("znver2")) ;
+	}
+      return 1 ;
+    }
+#endif
+  if ( nom == NULL || strcmp(nom, "base") == 0 )
+    {
+      choisit_base() ;
+      return 1 ;
+    }
+  return 0 ;
+}
+
+static void choisit_meilleure(void)
+{
+  choisit(NULL) ;
+}
+
+/*
+ * Force la version "base", "x86" ou "avx2", NULL pour la meilleure.
+ * Retourne 0 si le processeur ne sait pas faire (rien ne change).
+ * Sans appel, la meilleure est choisie une seule fois
+ * à la première utilisation, même par plusieurs fils d'exécution.
+ *
+ * C'est seulement pour les tests, qui vérifient ainsi les deux versions :
+ * le changement n'est pas atomique, il ne faut pas l'appeler pendant
+ * que d'autres fils d'exécution utilisent ces fonctions.
+ */
+
+int bit_force(const char *nom)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return choisit(nom) ;
+}
+
+/*
+ * "nb[i] = nb_bits_utile(v[i])" pour les "n" entiers de "v".
+ */
+
+void nb_bits_utile_tableau(const unsigned int *v, Position_Bit *nb, size_t n)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  (*version.nb_bits_utile_tableau)(v, nb, n) ;
+}
+
+/*
+ * Extraction/dépot des bits désignés par un masque (PEXT/PDEP).
+ *
+ * extrait_bits(0xABCD, 0x0F0F) --> 0xBD
+ * depose_bits(0xBD, 0x0F0F)    --> 0x0B0D
+ */
+
+unsigned long extrait_bits(unsigned long v, unsigned long masque)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return (*version.extrait_bits)(v, masque) ;
+}
+
+unsigned long depose_bits(unsigned long v, unsigned long masque)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return (*version.depose_bits)(v, masque) ;
+}
+
+/*
+ * Vrai si "extrait_bits" et "depose_bits" sont des instructions
+ * rapides : la version portable fait une boucle sur les bits du masque,
+ * les appelants gardent alors leur propre méthode.
+ */
+
+Booleen extrait_depose_rapides(void)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return version.rapides ;
+}
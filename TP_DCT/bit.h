@@ -5,6 +5,8 @@
 #ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_BIT_H
 #define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_BIT_H
 
+#include <stddef.h>
+
 /*
  * La valeur d'un bit.
  */
@@ -19,5 +21,12 @@ unsigned int nb_bits_utile(unsigned long) ;
 unsigned long         pow2(Position_Bit) ;
 Booleen          prend_bit(unsigned long, Position_Bit) ;
 unsigned long     pose_bit(unsigned long, Position_Bit, Booleen) ;
+unsigned int nb_zeros_gauche(unsigned long) ;
+void   nb_bits_utile_tableau(const unsigned int *v, Position_Bit *nb, size_t n) ;
+unsigned long   extrait_bits(unsigned long v, unsigned long masque) ;
+unsigned long    depose_bits(unsigned long v, unsigned long masque) ;
+Booleen extrait_depose_rapides(void) ; /**/
+
+int bit_force(const char *nom) ; /**/
 
 #endif
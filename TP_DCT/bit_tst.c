@@ -99,3 +99,125 @@ void pose_bit_tst()
 	}
     }	
 }
+
+void nb_zeros_gauche_tst()
+{
+  int i ;
+
+  if ( nb_zeros_gauche(0) != 8*sizeof(unsigned long) )
+    {
+      eprintf("nb_zeros_gauche(0) doit être la taille d'un unsigned long\n") ;
+      return ;
+    }
+  for(i=0; i<8*sizeof(unsigned long); i++)
+    if ( nb_zeros_gauche(1ul << i) != 8*sizeof(unsigned long) - 1 - i
+	 || nb_zeros_gauche((2ul << i) - 1) != 8*sizeof(unsigned long) - 1 - i)
+      {
+	eprintf("nb_zeros_gauche faux pour le bit %d\n", i) ;
+	return ;
+      }
+}
+
+static const char *versions_bit[] = { "base", "x86", "avx2" } ;
+
+void nb_bits_utile_tableau_tst()
+{
+  unsigned int v[1000] ;
+  Position_Bit nb[TAILLE(v)+1] ;
+  int i, k ;
+
+  for(i=0; i<TAILLE(v); i++)
+    v[i] = i < 40 ? i : (unsigned int)rand() >> (i % 32) ;
+  v[TAILLE(v)-1] = 0xFFFFFFFF ;
+  v[TAILLE(v)-2] = 0x80000000 ;
+  v[TAILLE(v)-3] = 0x7FFFFFFF ;	/* Arrondi à 2^31 en flottant */
+  v[TAILLE(v)-4] = 0x01FFFFFF ;
+  for(k=0; k<TAILLE(versions_bit); k++)
+    {
+      if ( bit_force(versions_bit[k]) == 0 )
+	continue ;
+      nb[TAILLE(v)] = 123 ;
+      nb_bits_utile_tableau(v, nb, TAILLE(v)) ;
+      for(i=0; i<TAILLE(v); i++)
+	if ( nb[i] != nb_bits_utile(v[i]) )
+	  {
+	    eprintf("nb_bits_utile_tableau (%s) : %d bits pour %u\n"
+		    , versions_bit[k], nb[i], v[i]) ;
+	    return ;
+	  }
+      if ( nb[TAILLE(v)] != 123 )
+	{
+	  eprintf("nb_bits_utile_tableau déborde du tableau\n") ;
+	  return ;
+	}
+    }
+  bit_force(NULL) ;
+}
+
+void extrait_bits_tst()
+{
+  unsigned long v, masque, r ;
+  int i, j, k, n ;
+
+  for(k=0; k<TAILLE(versions_bit); k++)
+    {
+      if ( bit_force(versions_bit[k]) == 0 )
+	continue ;
+      if ( extrait_bits(0xABCD, 0x0F0F) != 0xBD )
+	{
+	  eprintf("extrait_bits(0xABCD, 0x0F0F) != 0xBD (%s)\n"
+		  , versions_bit[k]) ;
+	  return ;
+	}
+      for(i=0; i<1000; i++)
+	{
+	  v = (unsigned long)rand() << 33 ^ rand() ;
+	  masque = (unsigned long)rand() << 31 ^ rand() ;
+	  r = extrait_bits(v, masque) ;
+	  for(j=0, n=0; j<8*sizeof(unsigned long); j++)
+	    if ( prend_bit(masque, j) )
+	      if ( prend_bit(r, n++) != prend_bit(v, j) )
+		{
+		  eprintf("extrait_bits(%lx, %lx) faux (%s)\n"
+			  , v, masque, versions_bit[k]) ;
+		  return ;
+		}
+	  if ( n < 8*sizeof(unsigned long) && (r >> n) != 0 )
+	    {
+	      eprintf("extrait_bits : les bits de gauche doivent être à 0\n") ;
+	      return ;
+	    }
+	}
+    }
+  bit_force(NULL) ;
+}
+
+void depose_bits_tst()
+{
+  unsigned long v, masque ;
+  int i, k ;
+
+  for(k=0; k<TAILLE(versions_bit); k++)
+    {
+      if ( bit_force(versions_bit[k]) == 0 )
+	continue ;
+      if ( depose_bits(0xBD, 0x0F0F) != 0x0B0D )
+	{
+	  eprintf("depose_bits(0xBD, 0x0F0F) != 0x0B0D (%s)\n"
+		  , versions_bit[k]) ;
+	  return ;
+	}
+      for(i=0; i<1000; i++)
+	{
+	  v = (unsigned long)rand() << 33 ^ rand() ;
+	  masque = (unsigned long)rand() << 31 ^ rand() ;
+	  if ( depose_bits(extrait_bits(v, masque), masque) != (v & masque) )
+	    {
+	      eprintf("depose_bits n'est pas l'inverse de extrait_bits (%s)\n"
+		      , versions_bit[k]) ;
+	      return ;
+	    }
+	}
+    }
+  bit_force(NULL) ;
+}
@@ -5,10 +5,16 @@
 #ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_BITS_H
 #define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_BITS_H
 
+#include <stddef.h>
+
 struct bitstream ;
 
 void         put_bits(struct bitstream *b, unsigned int nb, unsigned long v) ;
 unsigned int get_bits(struct bitstream *b, unsigned int nb) ;
+unsigned long peek_bits(struct bitstream *b, unsigned int nb) ;
+void        skip_bits(struct bitstream *b, unsigned int nb) ;
+void   put_bits_array(struct bitstream *b, unsigned int nb, const unsigned int *v, size_t n) ;
+void   get_bits_array(struct bitstream *b, unsigned int nb, unsigned int *v, size_t n) ;
 void   put_bit_string(struct bitstream *b, const char *bits) ;
 
 #endif
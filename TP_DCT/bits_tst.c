@@ -2,6 +2,7 @@
 #include "bits.h"
 #include "bitstream.h"
 #include "exception.h"
+#include "vecteur.h"
 
 #define N 1000
 
@@ -10,6 +11,61 @@ void put_bits_tst()
   int i, j ;
   struct bitstream *s ;
   FILE *f ;
+  unsigned char *zone ;
+  size_t taille ;
+
+  /*
+   * Des largeurs de 1 à 57 bits qui chevauchent l'accumulateur
+   * doivent donner le même fichier que des "put_bit"
+   */
+  s = open_bitstream("xxx", "w") ;
+  for(i=1; i<=57; i++)
+    put_bits(s, i, 0x123456789abcdefUL * i) ;
+  close_bitstream(s) ;
+
+  s = open_bitstream("xxx", "r") ;
+  for(i=1; i<=57; i++)
+    for(j=i; j>0; j--)
+      if ( get_bit(s) != prend_bit(0x123456789abcdefUL * i, j-1) )
+	{
+	  eprintf("put_bits(b, %d, v) n'écrit pas le bit %d de v\n", i, j-1) ;
+	  return ;
+	}
+  close_bitstream(s) ;
+
+  /*
+   * Flot LSB : le premier bit écrit est le poids faible du premier octet
+   * et "put_bits" commence par le poids faible de "v".
+   */
+  s = open_bitstream_memory(NULL, 0, "wL") ;
+  put_bits(s, 3, 5) ;
+  put_bits(s, 7, 0x7f) ;
+  put_bit(s, 0) ;
+  put_bits(s, 1, 1) ;
+  zone = close_bitstream_memory(s, &taille) ;
+  if ( taille != 2 || zone[0] != 0xFD || zone[1] != 0x0B )
+    {
+      eprintf("Flot LSB : octets %02x %02x au lieu de fd 0b\n"
+	      , zone[0], zone[1]) ;
+      return ;
+    }
+  free(zone) ;
+
+  s = open_bitstream_memory(NULL, 0, "wL") ;
+  for(i=1; i<=57; i++)
+    put_bits(s, i, 0x123456789abcdefUL * i) ;
+  zone = close_bitstream_memory(s, &taille) ;
+  s = open_bitstream_memory(zone, taille, "rL") ;
+  for(i=1; i<=57; i++)
+    for(j=0; j<i; j++)
+      if ( get_bit(s) != prend_bit(0x123456789abcdefUL * i, j) )
+	{
+	  eprintf("Flot LSB : put_bits(b, %d, v) n'écrit pas le bit %d de v\n"
+		  , i, j) ;
+	  return ;
+	}
+  close_bitstream(s) ;
+  free(zone) ;
 
   s = open_bitstream("xxx", "w") ;  
   for(i=0; i<N; i++)
@@ -48,6 +104,8 @@ void get_bits_tst()
   int i, j ;
   struct bitstream *s ;
   FILE *f ;
+  unsigned char *zone ;
+  size_t taille ;
 
   f = fopen("xxx", "r") ;  
   for(i=0; i<N; i++)
@@ -58,6 +116,29 @@ void get_bits_tst()
     }
   fclose(f) ;
 
+  /*
+   * Relecture LSB de largeurs de 1 à 57 bits
+   */
+  s = open_bitstream_memory(NULL, 0, "wl") ;
+  for(i=1; i<=57; i++)
+    put_bits(s, i, 0x123456789abcdefUL * i) ;
+  zone = close_bitstream_memory(s, &taille) ;
+  s = open_bitstream_memory(zone, taille, "rl") ;
+  for(i=1; i<=57; i++)
+    if ( get_bits(s, i) != (unsigned int)(0x123456789abcdefUL * i
+					  & ((2UL << (i-1)) - 1)) )
+      {
+	eprintf("Flot LSB : get_bits(b, %d) ne relit pas la valeur\n", i) ;
+	return ;
+      }
+  if ( peek_bits(s, 20) != 0 )
+    {
+      eprintf("Flot LSB : en fin de flot peek_bits complète avec des 0\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+  free(zone) ;
+
   s = open_bitstream("xxx", "r") ;
   if ( get_bits(s, 0) != 0 )
     	{
@@ -85,6 +166,211 @@ void get_bits_tst()
 }
 
 
+void peek_bits_tst()
+{
+  int i, j ;
+  struct bitstream *s ;
+
+  s = open_bitstream("xxx", "w") ;
+  for(i=0; i<N; i++)
+    put_bits(s, 13, i) ;
+  close_bitstream(s) ;
+
+  s = open_bitstream("xxx", "r") ;
+  for(i=0; i<N; i++)
+    {
+      j = peek_bits(s, 13) ;
+      if ( j != i || peek_bits(s, 13) != i )
+	{
+	  eprintf("peek_bits ne fonctionne pas, attendu : %d, lu : %d\n"
+		  , i, j) ;
+	  return ;
+	}
+      if ( peek_bits(s, 1) != (i >> 12) )
+	{
+	  eprintf("peek_bits(s, 1) ne retourne pas le premier bit\n") ;
+	  return ;
+	}
+      skip_bits(s, 13) ;
+    }
+  /* 13000 bits : il reste 4 bits de remplissage à 0 */
+  if ( peek_bits(s, 20) != 0 )
+    {
+      eprintf("En fin de fichier, peek_bits doit compléter avec des 0\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+}
+
+void skip_bits_tst()
+{
+  int i ;
+  volatile int t ;
+  struct bitstream *s ;
+
+  s = open_bitstream("xxx", "w") ;
+  for(i=0; i<N; i++)
+    {
+      put_bits(s, 57, 0) ;
+      put_bits(s, 7, i % 128) ;
+    }
+  close_bitstream(s) ;
+
+  s = open_bitstream("xxx", "r") ;
+  for(i=0; i<N; i++)
+    {
+      skip_bits(s, 57) ;
+      if ( get_bits(s, 7) != i % 128 )
+	{
+	  eprintf("skip_bits(s, 57) ne saute pas 57 bits\n") ;
+	  return ;
+	}
+    }
+  t = 0 ;
+  EXCEPTION(skip_bits(s, 1) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("skip_bits n'a pas lancé l'exception fin de fichier\n");
+      return ;
+    }
+  close_bitstream(s) ;
+}
+
+/*
+ * Les tableaux sont comparés avec des boucles de "put_bits"/"get_bits"
+ * pour toutes les versions des conversions supportées par le processeur,
+ * différentes largeurs, un décalage initial (aligné ou non)
+ * et les deux ordres de bits.
+ * Le fichier est assez gros pour que le tampon soit vidé/rechargé.
+ */
+
+#define NB_ARRAY 70001
+
+static const char *versions[] = { "base", "sse2", "avx2" } ;
+static const unsigned int largeurs[] = { 1, 7, 8, 13, 16, 31, 32 } ;
+static const char *ordres[][2] = { { "w", "r" }, { "wl", "rl" } } ;
+
+static unsigned int valeur_array(int i)
+{
+  return 0x9E3779B9u * (i + 1) ;
+}
+
+void put_bits_array_tst()
+{
+  struct bitstream *s ;
+  unsigned char *zone1, *zone2 ;
+  size_t taille1, taille2 ;
+  unsigned int *v ;
+  int i, j, k, o, decalage ;
+
+  ALLOUER(v, NB_ARRAY) ;
+  for(i=0; i<NB_ARRAY; i++)
+    v[i] = valeur_array(i) ;
+  for(k=0; k<TAILLE(versions); k++)
+    {
+      if ( vecteur_force(versions[k]) == 0 )
+	continue ;
+      bit_force(k == 0 ? "base" : NULL) ; /* Sans puis avec PEXT/PDEP */
+      for(j=0; j<TAILLE(largeurs); j++)
+	for(o=0; o<TAILLE(ordres); o++)
+	for(decalage=0; decalage<16; decalage += 5)
+	  {
+	    s = open_bitstream_memory(NULL, 0, ordres[o][0]) ;
+	    put_bits(s, decalage, 0x5555) ;
+	    for(i=0; i<NB_ARRAY; i++)
+	      put_bits(s, largeurs[j], v[i]) ;
+	    zone1 = close_bitstream_memory(s, &taille1) ;
+
+	    s = open_bitstream_memory(NULL, 0, ordres[o][0]) ;
+	    put_bits(s, decalage, 0x5555) ;
+	    put_bits_array(s, largeurs[j], v, 3) ;
+	    put_bits_array(s, largeurs[j], v + 3, NB_ARRAY - 3) ;
+	    zone2 = close_bitstream_memory(s, &taille2) ;
+
+	    if ( taille1 != taille2 || memcmp(zone1, zone2, taille1) != 0 )
+	      {
+		eprintf("put_bits_array (%s) : largeur %d décalage %d "
+			"mode %s différent de put_bits\n"
+			, versions[k], largeurs[j], decalage, ordres[o][0]) ;
+		return ;
+	      }
+	    free(zone1) ;
+	    free(zone2) ;
+	  }
+    }
+  vecteur_force(NULL) ;
+  bit_force(NULL) ;
+
+  s = open_bitstream("xxx", "w") ;
+  put_bits_array(s, 32, v, NB_ARRAY) ;
+  close_bitstream(s) ;
+  s = open_bitstream("xxx", "r") ;
+  for(i=0; i<NB_ARRAY; i++)
+    if ( get_bits(s, 32) != v[i] )
+      {
+	eprintf("put_bits_array dans un fichier : entier %d faux\n", i) ;
+	return ;
+      }
+  close_bitstream(s) ;
+  free(v) ;
+}
+
+void get_bits_array_tst()
+{
+  struct bitstream *s ;
+  unsigned int *v, masque ;
+  int i, j, k, o, decalage ;
+
+  ALLOUER(v, NB_ARRAY + 1) ;
+  for(k=0; k<TAILLE(versions); k++)
+    {
+      if ( vecteur_force(versions[k]) == 0 )
+	continue ;
+      bit_force(k == 0 ? "base" : NULL) ; /* Sans puis avec PEXT/PDEP */
+      for(j=0; j<TAILLE(largeurs); j++)
+	for(o=0; o<TAILLE(ordres); o++)
+	for(decalage=0; decalage<16; decalage += 8)
+	  {
+	    masque = (~0u) >> (32 - largeurs[j]) ;
+	    s = open_bitstream("xxx", ordres[o][0]) ;
+	    put_bits(s, decalage, 0x5555) ;
+	    for(i=0; i<NB_ARRAY; i++)
+	      put_bits(s, largeurs[j], valeur_array(i)) ;
+	    close_bitstream(s) ;
+
+	    s = k == 1 ? open_bitstream_mmap("xxx", ordres[o][1])
+	      : open_bitstream("xxx", ordres[o][1]) ;
+	    get_bits(s, decalage) ;
+	    v[NB_ARRAY] = 1234 ;
+	    get_bits_array(s, largeurs[j], v, 5) ;
+	    get_bits_array(s, largeurs[j], v + 5, NB_ARRAY - 5) ;
+	    for(i=0; i<NB_ARRAY; i++)
+	      if ( v[i] != (valeur_array(i) & masque) )
+		{
+		  eprintf("get_bits_array (%s) : largeur %d décalage %d "
+			  "mode %s entier %d faux\n"
+			  , versions[k], largeurs[j], decalage, ordres[o][1], i);
+		  return ;
+		}
+	    if ( v[NB_ARRAY] != 1234 )
+	      {
+		eprintf("get_bits_array déborde du tableau\n") ;
+		return ;
+	      }
+	    close_bitstream(s) ;
+	  }
+    }
+  vecteur_force(NULL) ;
+  bit_force(NULL) ;
+  free(v) ;
+}
+
 void put_bit_string_tst()
 {
   struct bitstream *s ;
@@ -1,4 +1,12 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include "bitstream.h"
+#include "asynchrone.h"
+#include "vecteur.h"
+#include "sortie.h"
+#include "crc.h"
+#include "bits.h"
 #include "exception.h"
 
 /*
@@ -20,29 +28,93 @@
  * On va donc stocker les bits un par un dans un entier (buffer)
  * et quand celui-ci sera plein, on le stockera dans le fichier.
  *
- * Pour la lecture, le procédé est inverse, on lit le buffer.
- * Puis on en extrait les bits un par un
+ * En écriture, le "buffer" est un accumulateur de 64 bits.
+ * Quand il est plein on le range dans "tampon" (8 octets d'un coup)
+ * et on ne fait réellement l'écriture dans le fichier
+ * que quand "tampon" est plein.
+ *
+ * Le flot peut aussi être en mémoire (voir "open_bitstream_memory"),
+ * dans ce cas "tampon" est directement la zone mémoire lue ou écrite
+ * et il n'y a pas de fichier.
+ *
+ * Pour la lecture, le procédé est inverse, on lit le fichier
+ * par blocs dans "tampon", on recharge le buffer (une fenêtre de 64 bits
+ * cadrée à gauche) à partir du tampon, puis on en extrait les bits
  * jusqu'à ce qu'il soit vide.
+ *
+ * Ordre des bits :
+ *    - Par défaut (MSB) le premier bit est le poids fort de chaque octet,
+ *      "buffer" est cadré à gauche et rangé poids fort en premier.
+ *    - Avec la lettre 'l' dans le mode (LSB) le premier bit est le poids
+ *      faible de chaque octet : "buffer" est cadré à droite et rangé
+ *      poids faible en premier. Sur x86 le rechargement est alors
+ *      une simple lecture de 64 bits et l'extraction un masque,
+ *      sans "bswap" ni décalage de la taille du champ.
+ *      Les 4 premiers octets du flot sont MAGIQUE_LSB pour que
+ *      le lecteur vérifie qu'il utilise le bon ordre.
+ *    - La lettre 'L' donne l'ordre LSB sans l'en-tête
+ *      (pour relire une partie d'un flot LSB, par exemple un segment).
+ * "put_bits(b, nb, v)" puis "get_bits(b, nb)" redonne "v" dans les
+ * deux ordres, les codeurs entropiques fonctionnent donc dans les deux
+ * tant que la lecture se fait par les mêmes appels que l'écriture.
  */
+enum bitstream_type
+{  Bitstream_fichier			     /* "tampon" est vidé dans "fichier" */
+  ,Bitstream_memoire			     /* Zone fournie par l'appelant */
+  ,Bitstream_memoire_extensible		     /* Zone allouée et agrandie ici */
+  ,Bitstream_projection			     /* Fichier projeté par "mmap" */
+  ,Bitstream_asynchrone			     /* Ecrit en tâche de fond */
+} ;
+
+#define MAGIQUE_LSB 0x0142534C		     /* "LSB\1" */
+
 struct bitstream
  {
+  enum bitstream_type type ;
+  Booleen        lsb ;			     /* Poids faible en premier */
   FILE          *fichier ;		     /* En lecture ou Ecriture */
   Buffer_Bit     buffer ;		     /* Tampon intermediaire */
   Position_Bit   nb_bits_dans_buffer ;	     /* Nb bits dans le tampon */
   Booleen        ecriture ;		     /* Faux, si ouvert avec "r" */
+  unsigned char *tampon ;		     /* Tampon ou zone mémoire */
+  size_t         taille_tampon ;	     /* Sa taille en octets */
+  size_t         nb_octets_tampon ;	     /* Nb octets utilisés */
+  size_t         position_tampon ;	     /* Lecture : prochain octet */
+  unsigned long  octets_precedents ;	     /* Octets du flot avant "tampon" */
+  long           origine ;		     /* Début du flot dans "fichier" */
+  void          *projection ;		     /* Début de la projection */
+  size_t         taille_projection ;
+  struct asynchrone *asynchrone ;	     /* Si Bitstream_asynchrone */
+  FILE          *json ;			     /* Statistiques à la fermeture */
+  const char    *nom ;
+  int            erreur ;		     /* Dernière exception signalée */
+  Booleen        crc_actif ;		     /* Voir "bitstream_crc_debut" */
+  unsigned int   crc ;			     /* CRC32C des octets avant... */
+  unsigned long  crc_position ;		     /* ...cette position du flot */
  } ;
 
+/*
+ * Les problèmes sont signalés sur le flot (voir "EXCEPTION_SIGNALE"
+ * dans "exception.h") : sans récupération "EXCEPTION" en cours,
+ * la fonction retourne "..." et "bitstream_erreur" donne l'exception.
+ */
+#define SIGNALE(B, VAL, ...) EXCEPTION_SIGNALE((B)->erreur, VAL, __VA_ARGS__)
+
+static int initialise_ordre(struct bitstream *b, const char *mode) ;
+
 /*
  * Cette fonction alloue la structure, l'initialise et ouvre le fichier.
  * Evidemment elle vide le buffer.
- * Le "mode" est passé tel quel à la fonction "fopen".
+ * Le "mode" est passé à la fonction "fopen" sans les lettres 'l' et 'L'
+ * qui choisissent l'ordre des bits (voir en haut du fichier).
  *
  * On considère que le fichier est ouvert en lecture si
  * le mode commence par 'r'
  *
  * Il faut que vous testiez un nom de fichier particulier : "-"
  *     - Ce fichier est l'entrée standard s'il est ouvert en lecture
- *     - Ce fichier est la sortie standard s'il est ouvert en écriture.
+ *     - Ce fichier est la sortie standard s'il est ouvert en écriture,
+ *       elle est écrite par "sortie_ecrit" (voir "sortie.h").
  *
  * Un fichier est ouvert en lecture ou ecriture.
  * Pas les deux en même en temps.
@@ -56,29 +128,349 @@ struct bitstream
 
 struct bitstream *open_bitstream(const char *fichier, const char* mode)
 {
-    struct bitstream *b;
-  	ALLOUER(b,1);
+  struct bitstream *b ;
+  FILE *f ;
+  char mode_fopen[8] ;
+  int i, j ;
+
+  for(i=j=0; mode[i] && j < sizeof(mode_fopen)-1; i++)
+    if ( mode[i] != 'l' && mode[i] != 'L' )
+      mode_fopen[j++] = mode[i] ;
+  mode_fopen[j] = '\0' ;
+
+  if ( strcmp(fichier, "-") == 0 )
+    f = mode[0] == 'r' ? stdin : stdout ;
+  else
+    f = fopen(fichier, mode_fopen) ;
+  if ( f == NULL )
+    EXCEPTION_SIGNALE(global_exception.derniere, Exception_fichier_ouverture
+		      , NULL) ;
+
+  ALLOUER(b, 1) ;
+  ALLOUER(b->tampon, TAILLE_TAMPON_BITSTREAM) ;
+  b->type = Bitstream_fichier ;
+  b->fichier = f ;
+  b->ecriture = mode[0] != 'r' ;
+  b->buffer = 0 ;
+  b->nb_bits_dans_buffer = 0 ;
+  b->taille_tampon = TAILLE_TAMPON_BITSTREAM ;
+  b->nb_octets_tampon = 0 ;
+  b->position_tampon = 0 ;
+  b->octets_precedents = 0 ;
+  b->origine = b->ecriture ? -1 : ftell(f) ; /* -1 si on ne peut pas */
+  b->json = NULL ;
+  b->erreur = 0 ;
+  b->crc_actif = Faux ;
+  return initialise_ordre(b, mode) ? NULL : b ;
+}
+
+/*
+ * Ouverture d'un flot de bits en mémoire, sans aucun fichier.
+ * Le "mode" est interprété comme pour "open_bitstream".
+ *
+ * En lecture, on lit les "taille" octets de "zone" (qui n'est pas copiée
+ * et doit donc rester valide jusqu'à la fermeture).
+ *
+ * En écriture :
+ *    - Si "zone" est NULL, la zone est allouée et agrandie
+ *      automatiquement, "taille" est sa taille initiale (0 possible).
+ *    - Sinon on écrit dans les "taille" octets de "zone"
+ *      et on lance l'exception "Exception_fichier_ecriture"
+ *      quand elle est pleine.
+ * Le résultat est récupéré (sans copie) par "close_bitstream_memory".
+ */
+
+struct bitstream *open_bitstream_memory(unsigned char *zone, size_t taille
+					, const char *mode)
+{
+  struct bitstream *b ;
+
+  ALLOUER(b, 1) ;
+  b->ecriture = mode[0] != 'r' ;
+  if ( zone == NULL && b->ecriture )
+    {
+      b->type = Bitstream_memoire_extensible ;
+      taille = MAX(taille, sizeof(Buffer_Bit)) ;
+      ALLOUER(zone, taille) ;
+    }
+  else
+    b->type = Bitstream_memoire ;
+  b->fichier = NULL ;
+  b->buffer = 0 ;
+  b->nb_bits_dans_buffer = 0 ;
+  b->tampon = zone ;
+  b->taille_tampon = taille ;
+  b->nb_octets_tampon = b->ecriture ? 0 : taille ;
+  b->position_tampon = 0 ;
+  b->octets_precedents = 0 ;
+  b->origine = -1 ;
+  b->json = NULL ;
+  b->erreur = 0 ;
+  b->crc_actif = Faux ;
+  return initialise_ordre(b, mode) ? NULL : b ;
+}
+
+/*
+ * Ouverture en lecture d'un fichier projeté en mémoire ("mmap").
+ * Les bits sont lus directement dans les pages du fichier :
+ * il n'y a ni "fread" ni copie dans un tampon.
+ *
+ * Le fichier "-" est l'entrée standard, elle est projetée si c'est
+ * un fichier normal (redirection "<") et la lecture commence à la
+ * position courante (les octets déjà lus par stdio sont sautés).
+ *
+ * Si le fichier ne peut pas être projeté (tube, fichier vide...)
+ * on se rabat sur "open_bitstream(fichier, mode)".
+ * Le "mode" commence par 'r', il peut contenir 'l' ou 'L'.
+ */
+
+struct bitstream *open_bitstream_mmap(const char *fichier, const char *mode)
+{
+  struct bitstream *b ;
+  struct stat st ;
+  void *projection ;
+  long debut ;
+  int fd ;
+
+  if ( strcmp(fichier, "-") == 0 )
+    {
+      fd = fileno(stdin) ;
+      debut = ftell(stdin) ;
+    }
+  else
+    {
+      fd = open(fichier, O_RDONLY) ;
+      if ( fd < 0 )
+	EXCEPTION_SIGNALE(global_exception.derniere
+			  , Exception_fichier_ouverture, NULL) ;
+      debut = 0 ;
+    }
+  projection = MAP_FAILED ;
+  if ( debut >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+       && st.st_size > debut )
+    projection = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+  if ( fd != fileno(stdin) )
+    close(fd) ;
+  if ( projection == MAP_FAILED )
+    return open_bitstream(fichier, mode) ;
+  madvise(projection, st.st_size, MADV_SEQUENTIAL) ;
+
+  b = open_bitstream_memory((unsigned char*)projection + debut
+			    , st.st_size - debut, "r") ;
+  b->type = Bitstream_projection ;
+  b->fichier = fd == fileno(stdin) ? stdin : NULL ;
+  b->projection = projection ;
+  b->taille_projection = st.st_size ;
+  return initialise_ordre(b, mode) ? NULL : b ;
+}
+
+/*
+ * Ouverture en écriture ("mode" est "w" ou "wl")
+ * avec "nb_tampons" tampons (au moins 2)
+ * de TAILLE_TAMPON_BITSTREAM octets.
+ * Quand un tampon est plein, il est écrit dans le fichier par un
+ * fil d'exécution en tâche de fond pendant que le codage continue
+ * dans un autre tampon.
+ *
+ * Une erreur d'écriture lance l'exception "Exception_fichier_ecriture"
+ * lors d'un échange de tampon suivant ou, au plus tard,
+ * dans "close_bitstream" qui attend la fin des écritures.
+ */
+
+struct bitstream *open_bitstream_asynchrone(const char *fichier
+					    , const char *mode
+					    , int nb_tampons)
+{
+  struct bitstream *b ;
+
+  b = open_bitstream(fichier, "w") ;	/* L'en-tête est écrit plus loin */
+  if ( b == NULL )
+    return NULL ;
+  if ( fflush(b->fichier) != 0 )	/* Ce qui a été écrit avant par stdio */
+    SIGNALE(b, Exception_fichier_ecriture, b) ;
+  if ( b->fichier == stdout && sortie_vide() ) /* Ou par "sortie_ecrit" */
+    SIGNALE(b, Exception_fichier_ecriture, b) ;
+  free(b->tampon) ;
+  b->type = Bitstream_asynchrone ;
+  b->asynchrone = open_asynchrone(fileno(b->fichier), nb_tampons
+				  , TAILLE_TAMPON_BITSTREAM) ;
+  b->tampon = asynchrone_echange(b->asynchrone, NULL, 0) ;
+  return initialise_ordre(b, mode) ? NULL : b ;
+}
+
+/*
+ * Choisit l'ordre des bits suivant le "mode" d'ouverture.
+ * Avec 'l', en écriture on écrit l'en-tête MAGIQUE_LSB
+ * et en lecture on le vérifie. S'il n'est pas là on ferme le flot
+ * et on lance l'exception
+ *         Exception_ordre_bits_invalide
+ * (sans récupération en cours, on retourne -1 et l'ouverture NULL).
+ */
+
+static int initialise_ordre(struct bitstream *b, const char *mode)
+{
+  b->lsb = strchr(mode, 'l') != NULL || strchr(mode, 'L') != NULL ;
+  if ( strchr(mode, 'l') == NULL )
+    return 0 ;
+  if ( b->ecriture )
+    put_bits(b, 32, MAGIQUE_LSB) ;
+  else
+    if ( peek_bits(b, 32) != MAGIQUE_LSB )
+      {
+	close_bitstream(b) ;
+	EXCEPTION_SIGNALE(global_exception.derniere
+			  , Exception_ordre_bits_invalide, -1) ;
+      }
+    else
+      skip_bits(b, 32) ;
+  return 0 ;
+}
+
+/*
+ * Lecture et écriture d'un mot de 64 bits dans le tampon,
+ * l'octet de poids fort en premier quelle que soit la machine.
+ */
+
+static inline Buffer_Bit charge_mot(const unsigned char *p)
+{
+  Buffer_Bit v ;
+
+  memcpy(&v, p, sizeof(v)) ;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  v = __builtin_bswap64(v) ;
+#endif
+  return v ;
+}
+
+static inline void stocke_mot(unsigned char *p, Buffer_Bit v)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  v = __builtin_bswap64(v) ;
+#endif
+  memcpy(p, &v, sizeof(v)) ;
+}
+
+/*
+ * Idem pour les flots LSB : l'octet de poids faible en premier,
+ * c'est un simple "memcpy" sur x86.
+ */
+
+static inline Buffer_Bit charge_mot_lsb(const unsigned char *p)
+{
+  Buffer_Bit v ;
 
-    b->ecriture = mode[0] != 'r';
+  memcpy(&v, p, sizeof(v)) ;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v) ;
+#endif
+  return v ;
+}
 
-  	if (strcmp(fichier,"-")==0){
-  		if (b->ecriture){
-  			b->fichier = stdout;
-  		}
-  		else {
-  			b->fichier = stdin;
-  		}
-  	}
-  	else {
-  		b->fichier = fopen(fichier,mode);
-  	}
-  	if (b->fichier == NULL){
-          free (b);
-  		EXCEPTION_LANCE(Exception_fichier_ouverture);
-  	}
-  	b->nb_bits_dans_buffer=0;
-  	b->buffer='\0';
-  	return b ; /* pour enlever un warning du compilateur */
+static inline void stocke_mot_lsb(unsigned char *p, Buffer_Bit v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v) ;
+#endif
+  memcpy(p, &v, sizeof(v)) ;
+}
+
+/*
+ * Ajoute au CRC les octets du tampon jusqu'à la position "fin"
+ * (en octets depuis le début du flot).
+ */
+
+static void ajoute_crc(struct bitstream *b, unsigned long fin)
+{
+  if ( fin <= b->crc_position )
+    return ;
+  b->crc = crc32c(b->crc, b->tampon + (b->crc_position - b->octets_precedents)
+		  , fin - b->crc_position) ;
+  b->crc_position = fin ;
+}
+
+/*
+ * Fait de la place dans "tampon" :
+ *    - Pour un fichier, on écrit les octets en attente.
+ *    - En asynchrone, on échange le tampon contre un tampon libre.
+ *    - Pour une zone extensible, on double sa taille.
+ *    - Pour une zone fournie par l'appelant, on ne peut rien faire.
+ *
+ * Si il y a une erreur d'écriture, elle lance l'exception :
+ *         "Exception_fichier_ecriture"
+ */
+
+static void vide_tampon(struct bitstream *b)
+{
+  unsigned char *zone ;
+  int erreur ;
+
+  if ( b->crc_actif )		/* Avant que les octets ne partent */
+    ajoute_crc(b, b->octets_precedents + b->nb_octets_tampon) ;
+  switch(b->type)
+    {
+    case Bitstream_fichier:
+      if ( b->nb_octets_tampon == 0 )
+	return ;
+      if ( b->fichier == stdout )
+	erreur = sortie_ecrit(b->tampon, b->nb_octets_tampon) ;
+      else
+	erreur = fwrite(b->tampon, 1, b->nb_octets_tampon, b->fichier)
+	  != b->nb_octets_tampon ;
+      b->octets_precedents += b->nb_octets_tampon ;
+      b->nb_octets_tampon = 0 ;	/* Même perdus, le tampon est libre */
+      if ( erreur )
+	SIGNALE(b, Exception_fichier_ecriture, ) ;
+      break ;
+    case Bitstream_asynchrone:
+      b->tampon = asynchrone_echange(b->asynchrone, b->tampon
+				     , b->nb_octets_tampon) ;
+      b->octets_precedents += b->nb_octets_tampon ;
+      b->nb_octets_tampon = 0 ;
+      if ( asynchrone_erreur(b->asynchrone) )
+	SIGNALE(b, Exception_fichier_ecriture, ) ;
+      break ;
+    case Bitstream_memoire_extensible:
+      zone = realloc(b->tampon, 2 * b->taille_tampon) ;
+      if ( zone == NULL )
+	SIGNALE(b, Exception_fichier_ecriture, ) ;
+      b->tampon = zone ;
+      b->taille_tampon *= 2 ;
+      break ;
+    case Bitstream_memoire:
+    case Bitstream_projection:
+      break ;
+    }
+}
+
+/*
+ * Range les "nb" premiers octets de l'accumulateur dans "tampon"
+ * (ceux de poids fort, ou de poids faible pour un flot LSB).
+ * On fait de la place dans le tampon s'il n'y en a plus assez.
+ */
+
+static void range_buffer(struct bitstream *b, unsigned int nb)
+{
+  unsigned char *p ;
+  unsigned int i ;
+
+  if ( b->nb_octets_tampon + sizeof(Buffer_Bit) > b->taille_tampon )
+    vide_tampon(b) ;
+  p = b->tampon + b->nb_octets_tampon ;
+  if ( b->nb_octets_tampon + sizeof(Buffer_Bit) <= b->taille_tampon )
+    {
+      if ( b->lsb )
+	stocke_mot_lsb(p, b->buffer) ;
+      else
+	stocke_mot(p, b->buffer) ;
+    }
+  else
+    {
+      if ( b->nb_octets_tampon + nb > b->taille_tampon )
+	SIGNALE(b, Exception_fichier_ecriture, ) ;
+      for(i=0; i<nb; i++)
+	p[i] = b->buffer >> (b->lsb ? 8*i : NB_BITS - 8 - 8*i) ;
+    }
+  b->nb_octets_tampon += nb ;
 }
 
 /*
@@ -92,26 +484,56 @@ struct bitstream *open_bitstream(const char *fichier, const char* mode)
  * Cette fonction n'est appelée que lorsque le fichier est ouvert
  * en écriture.
  *
+ * Les bits du dernier octet incomplet qui ne sont pas utilisés
+ * sont à 0.
+ *
  * Si il y a une erreur d'écriture, elle lance l'exception :
  *         "Exception_fichier_ecriture"
  */
 
- void flush_bitstream(struct bitstream *b)
- {
- 	if (b->fichier != NULL){
- 		if (b->ecriture){
- 			if (b->nb_bits_dans_buffer!=0){
-
- 				fputc(b->buffer,b->fichier);
- 			}
- 			b->buffer='/0';
- 			b->nb_bits_dans_buffer=0;
- 		}
- 	}
- 	else{
- 		EXCEPTION_LANCE(Exception_fichier_ecriture);
- 	}
- }
+void flush_bitstream(struct bitstream *b)
+{
+  if ( b->type == Bitstream_fichier && b->fichier == NULL )
+    SIGNALE(b, Exception_fichier_ecriture, ) ;
+  if ( !b->ecriture )
+    return ;
+  if ( b->nb_bits_dans_buffer != 0 )
+    range_buffer(b, (b->nb_bits_dans_buffer + 7) / 8) ;
+  if ( b->type == Bitstream_fichier || b->type == Bitstream_asynchrone )
+    vide_tampon(b) ;
+  b->buffer = 0 ;
+  b->nb_bits_dans_buffer = 0 ;
+}
+
+/*
+ * Demande l'écriture dans "json", à la fermeture du flot, d'un objet
+ * JSON (une ligne) donnant le nombre de bits écrits ou lus.
+ * Le décompte par symbole est fait par les "intstream"
+ * (voir "intstream_statistiques").
+ */
+
+void bitstream_statistiques(struct bitstream *b, FILE *json, const char *nom)
+{
+  b->json = json ;
+  b->nom = nom ;
+}
+
+static void ecrit_statistiques(const struct bitstream *b)
+{
+  static const char *types[] = { "fichier", "memoire", "memoire_extensible"
+				 , "projection", "asynchrone" } ;
+  unsigned long bits ;
+
+  if ( b->json == NULL )
+    return ;
+  bits = bitstream_tell_bits(b) ;
+  fprintf(b->json, "{\"bitstream\": \"%s\", \"type\": \"%s\""
+	  ", \"mode\": \"%s\", \"ordre\": \"%s\""
+	  ", \"bits\": %lu, \"octets\": %lu}\n"
+	  , b->nom, types[b->type], b->ecriture ? "ecriture" : "lecture"
+	  , b->lsb ? "lsb" : "msb", bits, (bits + 7) / 8) ;
+  fflush(b->json) ;
+}
 
 /*
  * Avant de fermer le fichier ouvert en écriture on copie le buffer
@@ -120,25 +542,124 @@ struct bitstream *open_bitstream(const char *fichier, const char* mode)
  *
  * Si jamais, il y a une erreur de fermeture, on lance l'exception
  *         Exception_fichier_fermeture
+ * (ou Exception_fichier_ecriture si les dernières écritures,
+ * y compris celles du fil asynchrone, ont échoué).
+ *
+ * Sans récupération "EXCEPTION" en cours, le flot n'existe plus
+ * pour garder l'erreur : on retourne son numéro, 0 si tout va bien.
+ * Une erreur d'écriture signalée avant la fermeture est aussi
+ * retournée, l'appelant n'a donc qu'un test à faire à la fin.
+ *
+ * Pour un flot en mémoire, la zone extensible est libérée,
+ * utilisez "close_bitstream_memory" pour la récupérer.
  */
 
- void close_bitstream(struct bitstream *b)
- {
-   int closeSignal;
- 	 if (b->fichier != NULL){
-         flush_bitstream(b);
- 		closeSignal=fclose(b->fichier);
-     }
-     if (closeSignal!=1)
-         free(b);
-     else
- 		EXCEPTION_LANCE(Exception_fichier_fermeture);
- }
+int close_bitstream(struct bitstream *b)
+{
+  int erreur, precedente ;
+
+  ecrit_statistiques(b) ;
+  flush_bitstream(b) ;
+  erreur = 0 ;
+  if ( b->type == Bitstream_asynchrone
+       && close_asynchrone(b->asynchrone, b->tampon, 0) )
+    erreur = Exception_fichier_ecriture ;
+  if ( b->fichier == stdout && sortie_vide() )
+    erreur = Exception_fichier_ecriture ;
+  if ( b->fichier != NULL && fclose(b->fichier) != 0 && erreur == 0 )
+    erreur = Exception_fichier_fermeture ;
+  switch(b->type)
+    {
+    case Bitstream_fichier:
+    case Bitstream_memoire_extensible:
+      free(b->tampon) ;
+      break ;
+    case Bitstream_projection:
+      if ( munmap(b->projection, b->taille_projection) != 0 && erreur == 0 )
+	erreur = Exception_fichier_fermeture ;
+      break ;
+    case Bitstream_memoire:
+    case Bitstream_asynchrone:
+      break ;
+    }
+  precedente = b->ecriture ? b->erreur : 0 ;
+  free(b) ;
+  /* Le flot n'existe plus : l'erreur ne peut être que dans le fil */
+  if ( erreur )
+    EXCEPTION_SIGNALE(global_exception.derniere, erreur, erreur) ;
+  return precedente ;
+}
+
+/*
+ * Fermeture d'un flot ouvert par "open_bitstream_memory".
+ * On retourne la zone mémoire (sans la copier) et on stocke dans
+ * "*taille" le nombre d'octets écrits (ou la taille lue).
+ * Pour une zone extensible c'est à l'appelant de faire le "free".
+ */
+
+unsigned char *close_bitstream_memory(struct bitstream *b, size_t *taille)
+{
+  unsigned char *zone ;
+
+  if ( b->type != Bitstream_memoire
+       && b->type != Bitstream_memoire_extensible )
+    EXIT ;
+  ecrit_statistiques(b) ;
+  flush_bitstream(b) ;
+  zone = b->tampon ;
+  if ( taille )
+    *taille = b->nb_octets_tampon ;
+  free(b) ;
+  return zone ;
+}
+
+/*
+ * Ajoute les "nb" (de 1 à NB_BITS) bits de droite de "v" dans
+ * l'accumulateur, du poids fort au poids faible.
+ * Quand l'accumulateur est plein, il est rangé dans le tampon
+ * et les bits qui restent repartent dans un accumulateur vide.
+ */
+
+static inline void ajoute_bits(struct bitstream *b, unsigned int nb
+			       , Buffer_Bit v)
+{
+  unsigned int libres ;
+
+  if ( ! b->ecriture )
+    SIGNALE(b, Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture, ) ;
+
+  v &= (~(Buffer_Bit)0) >> (NB_BITS - nb) ;
+  libres = NB_BITS - b->nb_bits_dans_buffer ;
+  if ( b->lsb )
+    {
+      /* Les bits s'ajoutent à gauche de ceux déjà présents */
+      b->buffer |= v << b->nb_bits_dans_buffer ;
+      if ( nb < libres )
+	{
+	  b->nb_bits_dans_buffer += nb ;
+	  return ;
+	}
+      range_buffer(b, sizeof(Buffer_Bit)) ;
+      b->nb_bits_dans_buffer = nb - libres ;
+      b->buffer = b->nb_bits_dans_buffer ? v >> libres : 0 ;
+      return ;
+    }
+  if ( nb < libres )
+    {
+      b->buffer |= v << (libres - nb) ;
+      b->nb_bits_dans_buffer += nb ;
+      return ;
+    }
+  b->buffer |= v >> (nb - libres) ;
+  range_buffer(b, sizeof(Buffer_Bit)) ;
+  b->nb_bits_dans_buffer = nb - libres ;
+  b->buffer = b->nb_bits_dans_buffer ? v << (NB_BITS-b->nb_bits_dans_buffer) : 0;
+}
 
 /*
  * Cette fonction ajoute le "bit" dans le buffer.
- *    - Si celui-ci est plein, alors on sauvegarde le buffer
- *      dans le fichier avec "flush_bitstream".
+ *    - Si celui-ci est plein, alors on le range dans le tampon
+ *      qui sera écrit dans le fichier quand il sera plein.
  *
  *    - On pose le bit dans le buffer.
  *
@@ -152,24 +673,177 @@ struct bitstream *open_bitstream(const char *fichier, const char* mode)
  *         Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture
  */
 
- void put_bit(struct bitstream *b, Booleen bit)
- {
- //    fprintf( stderr, "%d",bit);
- 	if (b->ecriture){
- 		if (b->nb_bits_dans_buffer==NB_BITS)
- 			flush_bitstream(b);
- 		b->nb_bits_dans_buffer++;
- 		b->buffer = pose_bit(b->buffer,NB_BITS - b-> nb_bits_dans_buffer ,bit);
- 	}
- 	else
- 		EXCEPTION_LANCE(Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture);
- }
+void put_bit(struct bitstream *b, Booleen bit)
+{
+  ajoute_bits(b, 1, bit != Faux) ;
+}
 
+/*
+ * On écrit les "nb" bits de droite de "v"
+ * dans le fichier (toujours du poids fort au faible).
+ *
+ * Pour v=11 nb=8 on va écrire les bits : 00001011 dans le fichier
+ *
+ * Cette fonction (déclarée dans "bits.h") est ici car elle ajoute
+ * les "nb" bits (jusqu'à NB_BITS) dans l'accumulateur en un seul décalage.
+ */
+
+void put_bits(struct bitstream *b, unsigned int nb, unsigned long v)
+{
+  if ( nb != 0 )
+    ajoute_bits(b, nb, v) ;
+}
+
+/*
+ * Ecrit les "n" entiers de "v" sur "nb" bits chacun (de 0 à 32),
+ * comme le ferait une boucle de "put_bits".
+ *
+ * Pour 8, 16 et 32 bits quand le flot est sur une frontière d'octet,
+ * les entiers sont convertis directement dans le tampon
+ * (voir "vecteur.c"). Sinon on les ajoute deux par deux
+ * dans l'accumulateur.
+ *
+ * Pour moins de 8 bits, si PEXT est rapide (voir "extrait_depose_rapides"),
+ * on met un entier par octet d'un "unsigned long" et "extrait_bits"
+ * garde les "nb" bits de droite de chaque octet, bout à bout :
+ * les OCTETS_LONG entiers partent en un seul "ajoute_bits".
+ */
+
+#define OCTETS_LONG sizeof(unsigned long)
+
+/* "nb" bits à 1 à droite de chaque octet */
+static unsigned long masque_octets(unsigned int nb)
+{
+  return (~0ul / 0xFF) * ((1u << nb) - 1) ;
+}
 
+void put_bits_array(struct bitstream *b, unsigned int nb
+		    , const unsigned int *v, size_t n)
+{
+  Buffer_Bit masque ;
+  unsigned int octets, i ;
+  unsigned long w, champs ;
+  size_t k ;
+
+  if ( ! b->ecriture )
+    SIGNALE(b, Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture, ) ;
+  if ( nb == 0 )
+    return ;
+  if ( (nb == 8 || nb == 16 || nb == 32) && b->nb_bits_dans_buffer % 8 == 0 )
+    {
+      octets = nb / 8 ;
+      if ( b->nb_bits_dans_buffer )
+	{
+	  range_buffer(b, b->nb_bits_dans_buffer / 8) ;
+	  b->buffer = 0 ;
+	  b->nb_bits_dans_buffer = 0 ;
+	}
+      while( n )
+	{
+	  if ( b->taille_tampon - b->nb_octets_tampon < octets )
+	    {
+	      vide_tampon(b) ;
+	      if ( b->taille_tampon - b->nb_octets_tampon < octets )
+		break ;		/* Zone pleine : exception plus bas */
+	    }
+	  k = MIN(n, (b->taille_tampon - b->nb_octets_tampon) / octets) ;
+	  entiers_vers_octets(b->tampon + b->nb_octets_tampon, v, k, octets
+			      , b->lsb) ;
+	  b->nb_octets_tampon += k * octets ;
+	  v += k ;
+	  n -= k ;
+	}
+    }
+  if ( nb < 8 && extrait_depose_rapides() )
+    {
+      champs = masque_octets(nb) ;
+      for( ; n >= OCTETS_LONG ; n -= OCTETS_LONG, v += OCTETS_LONG)
+	{
+	  /* Le premier entier est dans l'octet de droite en LSB */
+	  for(w=0, i=0; i<OCTETS_LONG; i++)
+	    w |= (unsigned long)(v[i] & 0xFF)
+	      << 8 * (b->lsb ? i : OCTETS_LONG - 1 - i) ;
+	  ajoute_bits(b, OCTETS_LONG * nb, extrait_bits(w, champs)) ;
+	}
+    }
+  masque = (~(Buffer_Bit)0) >> (NB_BITS - nb) ;
+  for( ; n >= 2 ; n -= 2, v += 2)
+    if ( b->lsb )		/* Le premier champ est à droite */
+      ajoute_bits(b, 2*nb, (v[0] & masque) | ((Buffer_Bit)v[1] << nb)) ;
+    else
+      ajoute_bits(b, 2*nb, ((Buffer_Bit)v[0] << nb) | (v[1] & masque)) ;
+  if ( n )
+    ajoute_bits(b, nb, v[0]) ;
+}
+
+/*
+ * Recharge la fenêtre de lecture ("buffer") à partir du tampon
+ * pour qu'elle contienne au moins NB_BITS-7 bits.
+ *
+ * Quand il reste au moins 8 octets dans le tampon on charge un mot
+ * complet sans aucun test : les octets déjà partiellement présents
+ * dans la fenêtre sont rechargés avec la même valeur, le "ou" ne
+ * change donc rien.
+ * Sinon on avance octet par octet en relisant le fichier
+ * par blocs quand le tampon est épuisé.
+ * En fin de fichier la fenêtre contient simplement moins de bits.
+ */
+
+static void remplit_buffer(struct bitstream *b)
+{
+  unsigned int nb_octets ;
+  size_t garde ;
+
+  if ( b->position_tampon + sizeof(Buffer_Bit) <= b->nb_octets_tampon )
+    {
+      if ( b->lsb )
+	b->buffer |= charge_mot_lsb(b->tampon + b->position_tampon)
+	  << b->nb_bits_dans_buffer ;
+      else
+	b->buffer |= charge_mot(b->tampon + b->position_tampon)
+	  >> b->nb_bits_dans_buffer ;
+      nb_octets = (NB_BITS - b->nb_bits_dans_buffer) / 8 ;
+      b->position_tampon += nb_octets ;
+      b->nb_bits_dans_buffer += 8 * nb_octets ;
+      return ;
+    }
+  while( b->nb_bits_dans_buffer <= NB_BITS - 8 )
+    {
+      if ( b->position_tampon == b->nb_octets_tampon )
+	{
+	  if ( b->type != Bitstream_fichier )
+	    return ;
+	  /*
+	   * On garde au début du tampon les octets encore dans la fenêtre :
+	   * l'octet de la position courante reste ainsi dans le tampon
+	   * (pour le CRC et "bitstream_seek_bits").
+	   */
+	  garde = MIN((b->nb_bits_dans_buffer + 7) / 8, b->nb_octets_tampon) ;
+	  if ( b->crc_actif )
+	    ajoute_crc(b, b->octets_precedents + b->nb_octets_tampon - garde);
+	  memmove(b->tampon, b->tampon + b->nb_octets_tampon - garde, garde) ;
+	  b->octets_precedents += b->nb_octets_tampon - garde ;
+	  b->nb_octets_tampon = garde + fread(b->tampon + garde, 1
+					      , b->taille_tampon - garde
+					      , b->fichier) ;
+	  b->position_tampon = garde ;
+	  if ( b->nb_octets_tampon == garde )
+	    return ;
+	  if ( b->nb_octets_tampon >= garde + sizeof(Buffer_Bit) )
+	    {
+	      remplit_buffer(b) ;
+	      return ;
+	    }
+	}
+      b->buffer |= (Buffer_Bit)b->tampon[b->position_tampon++]
+	<< (b->lsb ? b->nb_bits_dans_buffer : NB_BITS-8-b->nb_bits_dans_buffer);
+      b->nb_bits_dans_buffer += 8 ;
+    }
+}
 
 /*
  * Cette fonction lit un bit du buffer (du poid fort au poid faible)
- * Si le buffer est vide, elle va le lire dans le fichier.
+ * Si le buffer est vide, elle va le recharger à partir du fichier.
  * Les valeurs retournées possibles sont :
  *    - (Faux)
  *    - (Vrai)
@@ -177,12 +851,6 @@ struct bitstream *open_bitstream(const char *fichier, const char* mode)
  * Cette fonction n'est appelée que lorsque
  * le fichier est ouvert en lecture.
  *
- * ATTENTION ATTENTION : fgetc() RETOURNE UN int, PAS UN char.
- * faites donc attention aux affectations et aux tests par rapport à EOF.
- * Posez-vous les questions :
- *    - Pourquoi la valeur de retour est "int" et non "char"
- *    - Quel est le type de "b->buffer"
- *
  * En cas d'erreur de lecture (fin de fichier) on lance l'exception
  *         Exception_fichier_lecture
  *
@@ -190,25 +858,368 @@ struct bitstream *open_bitstream(const char *fichier, const char* mode)
  *         Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture
  */
 
- Booleen get_bit(struct bitstream *b)
- {
- 	if (b->ecriture)
- 		EXCEPTION_LANCE(Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture);
-     if (b->nb_bits_dans_buffer == 0){
-         int value = fgetc(b->fichier);
-         if (value == EOF)
-             EXCEPTION_LANCE(Exception_fichier_lecture);
-         b->buffer = value;
-         b->nb_bits_dans_buffer=8;
-     }
-     b->nb_bits_dans_buffer--;
-     return prend_bit(b->buffer,b->nb_bits_dans_buffer);
- }
+Booleen get_bit(struct bitstream *b)
+{
+  Booleen bit ;
+
+  if ( b->ecriture )
+    SIGNALE(b, Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture
+	    , Faux) ;
+  if ( b->nb_bits_dans_buffer == 0 )
+    {
+      remplit_buffer(b) ;
+      if ( b->nb_bits_dans_buffer == 0 )
+	SIGNALE(b, Exception_fichier_lecture, Faux) ;
+    }
+  if ( b->lsb )
+    {
+      bit = b->buffer & 1 ;
+      b->buffer >>= 1 ;
+    }
+  else
+    {
+      bit = b->buffer >> (NB_BITS - 1) ;
+      b->buffer <<= 1 ;
+    }
+  b->nb_bits_dans_buffer-- ;
+  return bit ;
+}
+
+/*
+ * Retourne les "nb" (de 0 à NB_BITS-7) prochains bits du fichier
+ * cadrés à droite SANS les consommer.
+ * En fin de fichier les bits manquants sont à 0,
+ * l'exception n'est lancée que si on essaye de les consommer.
+ * Pour un flot LSB le premier bit du flot est le poids faible du résultat.
+ */
+
+unsigned long peek_bits(struct bitstream *b, unsigned int nb)
+{
+  if ( b->ecriture )
+    SIGNALE(b, Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture, 0) ;
+  if ( nb == 0 )
+    return 0 ;
+  if ( b->nb_bits_dans_buffer < nb )
+    remplit_buffer(b) ;
+  if ( b->lsb )
+    return b->buffer & ((~(Buffer_Bit)0) >> (NB_BITS - nb)) ;
+  return b->buffer >> (NB_BITS - nb) ;
+}
+
+/*
+ * Consomme "nb" (de 0 à NB_BITS-7) bits.
+ * S'il n'y a pas assez de bits dans le fichier, on lance l'exception
+ *         Exception_fichier_lecture
+ */
+
+void skip_bits(struct bitstream *b, unsigned int nb)
+{
+  if ( b->ecriture )
+    SIGNALE(b, Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture, ) ;
+  if ( b->nb_bits_dans_buffer < nb )
+    {
+      remplit_buffer(b) ;
+      if ( b->nb_bits_dans_buffer < nb )
+	SIGNALE(b, Exception_fichier_lecture, ) ;
+    }
+  if ( b->lsb )
+    b->buffer >>= nb ;
+  else
+    b->buffer <<= nb ;
+  b->nb_bits_dans_buffer -= nb ;
+}
+
+/*
+ * Lecture de "nb" bits venant du fichier.
+ * et on retourne un entier contenant ces bits cadrés à droite (poids faibles)
+ * Par exemple pour nb=2 on peut retourner des valeurs de 0 à 3 inclu.
+ * Suivant les 2 bits dans le fichier on obtiendra :
+ * 00->0 01->1 10->2 11->3
+ *
+ * Cette fonction (déclarée dans "bits.h") est ici car elle lit
+ * directement la fenêtre : c'est un "peek_bits" suivi d'un "skip_bits".
+ */
+
+unsigned int get_bits(struct bitstream *b, unsigned int nb)
+{
+  unsigned int v ;
+
+  v = peek_bits(b, nb) ;
+  skip_bits(b, nb) ;
+  return v ;
+}
+
+/*
+ * Lit "n" entiers de "nb" bits chacun (de 0 à 32) dans "v",
+ * comme le ferait une boucle de "get_bits".
+ *
+ * Pour 8, 16 et 32 bits quand le flot est sur une frontière d'octet
+ * on rend au tampon les octets entiers de la fenêtre
+ * et on convertit directement le tampon (voir "vecteur.c").
+ * A la fin du tampon on passe par "get_bits" qui le recharge.
+ *
+ * Pour moins de 8 bits, si PDEP est rapide, on fait l'inverse de
+ * "put_bits_array" : "depose_bits" remet chaque entier dans un octet.
+ * En fin de flot on finit par "get_bits" qui signale l'erreur.
+ */
 
+void get_bits_array(struct bitstream *b, unsigned int nb
+		    , unsigned int *v, size_t n)
+{
+  unsigned int octets, i ;
+  unsigned long w, champs ;
+  size_t k ;
 
+  if ( b->ecriture )
+    SIGNALE(b, Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture, ) ;
+  if ( nb == 8 || nb == 16 || nb == 32 )
+    {
+      octets = nb / 8 ;
+      while( n
+	     && b->nb_bits_dans_buffer % 8 == 0
+	     && b->nb_bits_dans_buffer / 8 <= b->position_tampon )
+	{
+	  b->position_tampon -= b->nb_bits_dans_buffer / 8 ;
+	  b->buffer = 0 ;
+	  b->nb_bits_dans_buffer = 0 ;
+	  k = MIN(n, (b->nb_octets_tampon - b->position_tampon) / octets) ;
+	  if ( k )
+	    {
+	      octets_vers_entiers(v, b->tampon + b->position_tampon, k, octets
+				  , b->lsb) ;
+	      b->position_tampon += k * octets ;
+	    }
+	  else
+	    {
+	      *v = get_bits(b, nb) ;
+	      k = 1 ;
+	    }
+	  v += k ;
+	  n -= k ;
+	}
+    }
+  if ( nb != 0 && nb < 8 && extrait_depose_rapides() )
+    {
+      champs = masque_octets(nb) ;
+      for( ; n >= OCTETS_LONG ; n -= OCTETS_LONG, v += OCTETS_LONG)
+	{
+	  w = peek_bits(b, OCTETS_LONG * nb) ;
+	  if ( b->nb_bits_dans_buffer < OCTETS_LONG * nb )
+	    break ;
+	  skip_bits(b, OCTETS_LONG * nb) ;
+	  w = depose_bits(w, champs) ;
+	  for(i=0; i<OCTETS_LONG; i++)
+	    v[i] = (w >> 8 * (b->lsb ? i : OCTETS_LONG - 1 - i)) & 0xFF ;
+	}
+    }
+  for( ; n ; n--)
+    *v++ = get_bits(b, nb) ;
+}
 
+/*
+ * Position courante en bits depuis le début du flot :
+ *    - En écriture, le nombre de bits écrits (même non vidés).
+ *    - En lecture, le nombre de bits consommés.
+ * Les bits déjà chargés dans la fenêtre mais non lus ne comptent pas.
+ */
 
+unsigned long bitstream_tell_bits(const struct bitstream *b)
+{
+  unsigned long octets ;
 
+  if ( b->ecriture )
+    return 8 * (b->octets_precedents + b->nb_octets_tampon)
+      + b->nb_bits_dans_buffer ;
+  octets = b->octets_precedents + b->position_tampon ;
+  return 8 * octets - b->nb_bits_dans_buffer ;
+}
+
+/*
+ * Avance jusqu'à la prochaine frontière d'octet.
+ *    - En écriture, on complète l'octet courant avec des 0.
+ *    - En lecture, on saute les bits qui restent dans l'octet courant.
+ * Ne fait rien si on est déjà sur une frontière d'octet.
+ */
+
+void bitstream_align(struct bitstream *b)
+{
+  unsigned int reste ;
+
+  reste = bitstream_tell_bits(b) % 8 ;
+  if ( reste == 0 )
+    return ;
+  if ( b->ecriture )
+    put_bits(b, 8 - reste, 0) ;
+  else
+    skip_bits(b, 8 - reste) ;
+}
+
+/*
+ * CRC32C (voir "crc.h") des octets écrits ou lus
+ * entre "bitstream_crc_debut" et "bitstream_crc_fin".
+ * Les deux alignent d'abord le flot sur une frontière d'octet.
+ * Le CRC est calculé par morceaux au fur et à mesure que les octets
+ * passent dans le tampon, sans relire le fichier.
+ * Il ne faut pas utiliser "bitstream_seek_bits" entre les deux.
+ */
+
+void bitstream_crc_debut(struct bitstream *b)
+{
+  bitstream_align(b) ;
+  b->crc_actif = Vrai ;
+  b->crc = 0 ;
+  b->crc_position = bitstream_tell_bits(b) / 8 ;
+}
+
+/*
+ * Retourne Faux si aucun CRC n'était en cours,
+ * sinon range le CRC dans "*crc" et arrête le calcul.
+ */
+
+Booleen bitstream_crc_fin(struct bitstream *b, unsigned int *crc)
+{
+  if ( ! b->crc_actif )
+    return Faux ;
+  bitstream_align(b) ;
+  if ( b->ecriture && b->nb_bits_dans_buffer )
+    {
+      /* Les octets complets de l'accumulateur passent dans le tampon */
+      range_buffer(b, b->nb_bits_dans_buffer / 8) ;
+      b->buffer = 0 ;
+      b->nb_bits_dans_buffer = 0 ;
+    }
+  ajoute_crc(b, bitstream_tell_bits(b) / 8) ;
+  b->crc_actif = Faux ;
+  *crc = b->crc ;
+  return Vrai ;
+}
+
+/*
+ * Lecture seulement : la prochaine lecture se fera au bit "position"
+ * (compté comme pour "bitstream_tell_bits").
+ *
+ * Si la position est dans le tampon (toujours le cas en mémoire
+ * ou avec "mmap") on déplace simplement la lecture.
+ * Sinon on fait un "fseek" dans le fichier, si il n'est pas
+ * possible (tube, terminal) on lance l'exception
+ *         Exception_fichier_positionnement
+ * Se positionner après la fin du flot lance l'exception
+ *         Exception_fichier_lecture
+ */
+
+void bitstream_seek_bits(struct bitstream *b, unsigned long position)
+{
+  unsigned long octet ;
+
+  if ( b->ecriture )
+    SIGNALE(b, Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture, ) ;
+  octet = position / 8 ;
+  if ( octet >= b->octets_precedents
+       && octet <= b->octets_precedents + b->nb_octets_tampon )
+    b->position_tampon = octet - b->octets_precedents ;
+  else
+    {
+      if ( b->type != Bitstream_fichier ) /* Tout le flot est en mémoire */
+	SIGNALE(b, Exception_fichier_lecture, ) ;
+      if ( b->origine < 0 )
+	SIGNALE(b, Exception_fichier_positionnement, ) ;
+      if ( fseek(b->fichier, b->origine + octet, SEEK_SET) != 0 )
+	SIGNALE(b, Exception_fichier_positionnement, ) ;
+      b->octets_precedents = octet ;
+      b->nb_octets_tampon = 0 ;
+      b->position_tampon = 0 ;
+    }
+  b->buffer = 0 ;
+  b->nb_bits_dans_buffer = 0 ;
+  skip_bits(b, position % 8) ;
+}
+
+/*
+ * Ouvre en lecture les "nb_octets" du flot "b" qui commencent
+ * à l'octet "debut", sans copie : le sous flot lit directement
+ * la zone mémoire de "b" qui doit rester ouvert.
+ * C'est ce qui permet de décoder des segments en parallèle.
+ *
+ * Seuls les flots en mémoire ou projetés ont tout leur contenu
+ * en mémoire, sinon on lance l'exception
+ *         Exception_fichier_positionnement
+ * Si la zone déborde du flot, on lance l'exception
+ *         Exception_fichier_lecture
+ */
+
+struct bitstream *open_bitstream_sous_flot(const struct bitstream *b
+					   , unsigned long debut
+					   , size_t nb_octets)
+{
+  int erreur ;
+
+  if ( b->ecriture )
+    erreur = Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture ;
+  else if ( b->type != Bitstream_memoire && b->type != Bitstream_projection )
+    erreur = Exception_fichier_positionnement ;
+  else if ( debut > b->nb_octets_tampon
+	    || nb_octets > b->nb_octets_tampon - debut )
+    erreur = Exception_fichier_lecture ;
+  else
+    erreur = 0 ;
+  if ( erreur )			/* "b" est constant, il n'est pas marqué */
+    EXCEPTION_SIGNALE(global_exception.derniere, erreur, NULL) ;
+  return open_bitstream_memory(b->tampon + debut, nb_octets
+			       , b->lsb ? "rL" : "r") ;
+}
+
+/*
+ * Lecture seulement : tout le contenu d'un flot en mémoire ou projeté,
+ * dont "*taille" reçoit la taille en octets.
+ * Retourne NULL pour les autres flots (ils ne sont pas en mémoire).
+ */
+
+const unsigned char *bitstream_zone(const struct bitstream *b, size_t *taille)
+{
+  if ( b->ecriture
+       || (b->type != Bitstream_memoire && b->type != Bitstream_projection) )
+    return NULL ;
+  *taille = b->nb_octets_tampon ;
+  return b->tampon ;
+}
+
+
+/*
+ * Dernière exception signalée sur le flot (0 si aucune).
+ * Quand aucune récupération "EXCEPTION" n'est en cours dans le fil
+ * d'exécution, les fonctions ne lancent pas d'exception : elles
+ * retournent (0 pour une lecture) et c'est ici qu'on voit le problème.
+ * Par exemple, la fin du fichier est atteinte quand
+ * "bitstream_erreur(b) == Exception_fichier_lecture".
+ */
+
+int bitstream_erreur(const struct bitstream *b)
+{
+  return b->erreur ;
+}
+
+/*
+ * Pour les codeurs construits au-dessus du flot :
+ * signale l'exception "exception" sur le flot comme le ferait
+ * une fonction de ce fichier. Si elle retourne, l'appelant doit
+ * abandonner et retourner lui aussi.
+ */
+
+void bitstream_signale(struct bitstream *b, int exception)
+{
+  SIGNALE(b, exception, ) ;
+}
+
+/*
+ * Vrai si le flot est "poids faible en premier" (mode 'l' ou 'L').
+ * Un codeur qui range plusieurs champs en un seul "put_bits"
+ * doit savoir dans quel ordre ils sortent.
+ */
+
+Booleen bitstream_lsb(const struct bitstream *b)
+{
+  return b->lsb ;
+}
 
 
 /*
@@ -8,23 +8,48 @@
 #include "bases.h"
 #include "bit.h"
 
+#include <stdint.h>
+
 /*
- * Le buffer dans lequel on stocke les bits.
- * On pourrai prendre "long" mais il faudrait alors
- * déterminer si la machine est Little or Big Endian
+ * Le buffer dans lequel on accumule les bits avant de les stocker.
+ * On prend un entier de 64 bits : les bits y sont cadrés à gauche
+ * (le premier bit écrit est le poids fort).
+ * Pour ne pas dépendre de l'ordre des octets de la machine (Little
+ * ou Big Endian) on le range dans le tampon octet par octet,
+ * poids fort en premier.
  */
-typedef unsigned char Buffer_Bit ;
+typedef uint64_t Buffer_Bit ;
 /*
  * Nombre de bit dans le buffer
  */
 #define NB_BITS (8*sizeof(Buffer_Bit))
+/*
+ * Taille en octets du tampon d'entrée/sortie.
+ * C'est un multiple de "sizeof(Buffer_Bit)"
+ */
+#define TAILLE_TAMPON_BITSTREAM 65536
 
 struct bitstream ;
 
 struct bitstream  *open_bitstream(const char *fichier, const char* mode) ;
-void              close_bitstream(struct bitstream *b) ;
+int               close_bitstream(struct bitstream *b) ;
+struct bitstream  *open_bitstream_memory(unsigned char *zone, size_t taille, const char *mode) ;
+unsigned char    *close_bitstream_memory(struct bitstream *b, size_t *taille) ;
+struct bitstream  *open_bitstream_mmap(const char *fichier, const char *mode) ;
+struct bitstream  *open_bitstream_asynchrone(const char *fichier, const char *mode, int nb_tampons) ;
 void                      put_bit(struct bitstream *b, Booleen bit) ;
 Booleen 	          get_bit(struct bitstream *b) ;
+unsigned long  bitstream_tell_bits(const struct bitstream *b) ;
+void               bitstream_align(struct bitstream *b) ;
+void           bitstream_seek_bits(struct bitstream *b, unsigned long position) ;
+void        bitstream_statistiques(struct bitstream *b, FILE *json, const char *nom) ;
+void           bitstream_crc_debut(struct bitstream *b) ;
+Booleen          bitstream_crc_fin(struct bitstream *b, unsigned int *crc) ;
+struct bitstream  *open_bitstream_sous_flot(const struct bitstream *b, unsigned long debut, size_t nb_octets) ;
+const unsigned char *bitstream_zone(const struct bitstream *b, size_t *taille) ;
+int               bitstream_erreur(const struct bitstream *b) ;
+void             bitstream_signale(struct bitstream *b, int exception) ;
+Booleen              bitstream_lsb(const struct bitstream *b) ;
 
 FILE          *bitstream_get_file(const struct bitstream *b) ; /**/
 Booleen     bitstream_en_ecriture(const struct bitstream *b) ; /**/
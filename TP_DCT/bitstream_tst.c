@@ -1,8 +1,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include "crc.h"
 
 #include "bitstream.h"
+#include "bits.h"
 #include "exception.h"
 #include "bases.h"
 
@@ -194,6 +197,320 @@ void close_bitstream_tst()
   close_bitstream(bs2) ;
 }
 
+/*
+ * L'ordre LSB est noté au début du flot par "LSB\1"
+ */
+
+static void open_bitstream_lsb_test()
+{
+  struct bitstream *s ;
+  unsigned char *zone ;
+  size_t taille ;
+  volatile int t ;
+
+  s = open_bitstream_memory(NULL, 0, "wl") ;
+  put_bits(s, 8, 0x81) ;
+  zone = close_bitstream_memory(s, &taille) ;
+  if ( taille != 5 || memcmp(zone, "LSB\1\x81", 5) != 0 )
+    {
+      eprintf("Un flot ouvert en \"wl\" doit commencer par \"LSB\\1\"\n") ;
+      return ;
+    }
+  s = open_bitstream_memory(zone, taille, "rl") ;
+  if ( !bitstream_lsb(s) || bitstream_tell_bits(s) != 32
+       || get_bits(s, 8) != 0x81 )
+    {
+      eprintf("Relecture d'un flot LSB incorrecte\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+
+  t = 0 ;
+  EXCEPTION(s = open_bitstream_memory(zone + 1, taille - 1, "rl") ;
+	    ,
+	    ,
+	    case Exception_ordre_bits_invalide:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Lire en \"rl\" un flot sans en-tête LSB doit échouer\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+void open_bitstream_memory_tst()
+{
+  struct bitstream *s ;
+  unsigned char zone[3] = { 0x12, 0x34, 0x56 } ;
+  int i ;
+  volatile int t ;
+
+  s = open_bitstream_memory(zone, sizeof(zone), "r") ;
+  if ( bitstream_en_ecriture(s) || bitstream_get_file(s) != NULL )
+    {
+      eprintf("open_bitstream_memory(zone, 3, \"r\") : mauvaise ouverture\n") ;
+      return ;
+    }
+  for(i=0; i<3*8; i++)
+    if ( get_bit(s) != prend_bit(zone[i/8], 7 - i%8) )
+      {
+	eprintf("Lecture en mémoire : mauvais bit %d\n", i) ;
+	return ;
+      }
+  t = 0 ;
+  EXCEPTION(get_bit(s) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Pas d'exception en fin de zone mémoire\n");
+      return ;
+    }
+  close_bitstream(s) ;
+
+  open_bitstream_lsb_test() ;
+
+  /*
+   * Zone fournie trop petite
+   */
+  s = open_bitstream_memory(zone, sizeof(zone), "w") ;
+  put_bits(s, 24, 0xabcdef) ;
+  flush_bitstream(s) ;
+  t = 0 ;
+  EXCEPTION(put_bit(s, 1) ;
+	    flush_bitstream(s) ;
+	    ,
+	    ,
+	    case Exception_fichier_ecriture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 || zone[0] != 0xab || zone[1] != 0xcd || zone[2] != 0xef )
+    {
+      eprintf("Ecriture en mémoire dans une zone de 3 octets\n");
+      return ;
+    }
+}
+
+void close_bitstream_memory_tst()
+{
+  struct bitstream *s ;
+  unsigned char *zone ;
+  size_t taille ;
+  int i ;
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  for(i=0; i<100000; i++)
+    put_bits(s, 17, i) ;
+  put_bit(s, 1) ;
+  zone = close_bitstream_memory(s, &taille) ;
+  if ( taille != (100000*17 + 1 + 7) / 8 )
+    {
+      eprintf("close_bitstream_memory : taille %lu au lieu de %d\n"
+	      , (unsigned long)taille, (100000*17 + 1 + 7) / 8) ;
+      return ;
+    }
+
+  s = open_bitstream_memory(zone, taille, "r") ;
+  for(i=0; i<100000; i++)
+    if ( get_bits(s, 17) != i )
+      {
+	eprintf("Relecture en mémoire de l'entier %d incorrecte\n", i) ;
+	return ;
+      }
+  if ( get_bits(s, 8) != 0x80 )
+    {
+      eprintf("Le dernier octet est mal complété\n") ;
+      return ;
+    }
+  if ( close_bitstream_memory(s, &taille) != zone )
+    {
+      eprintf("close_bitstream_memory ne retourne pas la zone lue\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+void open_bitstream_mmap_tst()
+{
+  struct bitstream *s ;
+  int i ;
+  volatile int t ;
+
+  s = open_bitstream("xxx", "w") ;
+  for(i=0; i<100000; i++)
+    put_bits(s, 11, i) ;
+  close_bitstream(s) ;
+
+  s = open_bitstream_mmap("xxx", "r") ;
+  if ( bitstream_en_ecriture(s) )
+    {
+      eprintf("open_bitstream_mmap n'ouvre pas en lecture\n") ;
+      return ;
+    }
+  for(i=0; i<100000; i++)
+    if ( get_bits(s, 11) != i % 2048 )
+      {
+	eprintf("Lecture projetée de l'entier %d incorrecte\n", i) ;
+	return ;
+      }
+  t = 0 ;
+  EXCEPTION(get_bits(s, 8) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Pas d'exception en fin de fichier projeté\n");
+      return ;
+    }
+  close_bitstream(s) ;
+
+  t = 0 ;
+  EXCEPTION(open_bitstream_mmap("xxx/inexistant", "r") ;
+	    ,
+	    ,
+	    case Exception_fichier_ouverture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("open_bitstream_mmap d'un fichier inexistant\n");
+      return ;
+    }
+}
+
+void bitstream_zone_tst()
+{
+  static unsigned char zone[] = { 1, 2, 3 } ;
+  const unsigned char *z ;
+  struct bitstream *s ;
+  size_t taille ;
+
+  s = open_bitstream_memory(zone, sizeof(zone), "r") ;
+  get_bits(s, 8) ;
+  z = bitstream_zone(s, &taille) ;
+  if ( z != zone || taille != sizeof(zone) )
+    {
+      eprintf("bitstream_zone doit donner toute la zone lue\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  if ( bitstream_zone(s, &taille) != NULL )
+    {
+      eprintf("bitstream_zone : pas de zone pour un flot en écriture\n") ;
+      return ;
+    }
+  free(close_bitstream_memory(s, NULL)) ;
+
+  s = open_bitstream("xxx", "w") ;
+  put_bits(s, 24, 0x010203) ;
+  close_bitstream(s) ;
+  s = open_bitstream_mmap("xxx", "r") ;
+  z = bitstream_zone(s, &taille) ;
+  if ( z == NULL || taille != 3 || memcmp(z, zone, 3) != 0 )
+    {
+      eprintf("bitstream_zone : mauvaise zone pour un fichier projeté\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+  s = open_bitstream("xxx", "r") ;
+  if ( bitstream_zone(s, &taille) != NULL )
+    {
+      eprintf("bitstream_zone : un fichier lu par blocs n'est pas en mémoire\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+}
+
+/*
+ * Sans récupération "EXCEPTION" (dans un autre fil d'exécution),
+ * l'erreur du fil d'écriture est retournée par "close_bitstream".
+ */
+
+static void *ecrit_sans_recuperation(void *arg)
+{
+  struct bitstream *s ;
+  int *resultat = arg ;
+  int i ;
+
+  s = open_bitstream_asynchrone("/dev/full", "w", 2) ;
+  for(i=0; i<1000000; i++)
+    put_bits(s, 23, i) ;
+  *resultat = close_bitstream(s) ;
+  return NULL ;
+}
+
+void open_bitstream_asynchrone_tst()
+{
+  struct bitstream *s ;
+  pthread_t fil ;
+  int i ;
+  volatile int t ;
+
+  s = open_bitstream_asynchrone("xxx", "w", 2) ;
+  if ( !bitstream_en_ecriture(s) )
+    {
+      eprintf("open_bitstream_asynchrone n'ouvre pas en écriture\n") ;
+      return ;
+    }
+  for(i=0; i<1000000; i++)
+    put_bits(s, 23, i) ;
+  close_bitstream(s) ;
+
+  s = open_bitstream("xxx", "r") ;
+  for(i=0; i<1000000; i++)
+    if ( get_bits(s, 23) != i )
+      {
+	eprintf("Ecriture asynchrone de l'entier %d incorrecte\n", i) ;
+	return ;
+      }
+  close_bitstream(s) ;
+
+  /*
+   * L'erreur d'écriture doit remonter au plus tard à la fermeture
+   */
+  t = 0 ;
+  EXCEPTION(s = open_bitstream_asynchrone("/dev/full", "w", 3) ;
+	    for(i=0; i<1000000; i++)
+	      put_bits(s, 23, i) ;
+	    close_bitstream(s) ;
+	    ,
+	    ,
+	    case Exception_fichier_ecriture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Une erreur d'écriture asynchrone n'est pas signalée\n") ;
+      return ;
+    }
+
+  t = 0 ;
+  pthread_create(&fil, NULL, ecrit_sans_recuperation, (int*)&t) ;
+  pthread_join(fil, NULL) ;
+  if ( t != Exception_fichier_ecriture )
+    {
+      eprintf("close_bitstream retourne %d au lieu de l'erreur d'écriture\n"
+	      , t) ;
+      return ;
+    }
+}
+
 void put_bit_tst()
 {
   struct bitstream *s ;
@@ -347,3 +664,494 @@ void get_bit_tst()
 
 }
 
+
+void bitstream_tell_bits_tst()
+{
+  struct bitstream *s ;
+  int i, j ;
+
+  for(j=0; j<2; j++)
+    {
+      s = open_bitstream("xxx", "w") ;
+      for(i=0; i<100000; i++)
+	{
+	  if ( bitstream_tell_bits(s) != 17UL * i )
+	    {
+	      eprintf("Ecriture : position %lu au lieu de %lu\n"
+		      , bitstream_tell_bits(s), 17UL * i) ;
+	      return ;
+	    }
+	  put_bits(s, 17, i) ;
+	}
+      close_bitstream(s) ;
+
+      s = j ? open_bitstream_mmap("xxx", "r") : open_bitstream("xxx", "r") ;
+      for(i=0; i<100000; i++)
+	{
+	  if ( bitstream_tell_bits(s) != 17UL * i )
+	    {
+	      eprintf("Lecture%s : position %lu au lieu de %lu\n"
+		      , j ? " (mmap)" : "", bitstream_tell_bits(s), 17UL * i) ;
+	      return ;
+	    }
+	  if ( i % 3 )
+	    peek_bits(s, 57) ;
+	  get_bits(s, 17) ;
+	}
+      close_bitstream(s) ;
+    }
+}
+
+void bitstream_align_tst()
+{
+  struct bitstream *s ;
+  unsigned char *zone ;
+  size_t taille ;
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  bitstream_align(s) ;
+  put_bits(s, 3, 7) ;
+  bitstream_align(s) ;
+  put_bits(s, 8, 0x5a) ;
+  bitstream_align(s) ;
+  put_bits(s, 1, 1) ;
+  if ( bitstream_tell_bits(s) != 17 )
+    {
+      eprintf("Ecriture : position %lu au lieu de 17\n"
+	      , bitstream_tell_bits(s)) ;
+      return ;
+    }
+  zone = close_bitstream_memory(s, &taille) ;
+  if ( taille != 3 || zone[0] != 0xe0 || zone[1] != 0x5a || zone[2] != 0x80 )
+    {
+      eprintf("L'alignement en écriture doit compléter avec des 0\n") ;
+      return ;
+    }
+
+  s = open_bitstream_memory(zone, taille, "r") ;
+  get_bits(s, 3) ;
+  bitstream_align(s) ;
+  if ( bitstream_tell_bits(s) != 8 || get_bits(s, 8) != 0x5a )
+    {
+      eprintf("Lecture : l'alignement n'a pas sauté les bons bits\n") ;
+      return ;
+    }
+  bitstream_align(s) ;
+  if ( get_bit(s) != 1 )
+    {
+      eprintf("Lecture : aligner sur une frontière ne doit rien faire\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+  free(zone) ;
+}
+
+void bitstream_seek_bits_tst()
+{
+  struct bitstream *s ;
+  static unsigned long positions[] = { 17*99999, 0, 5, 17*5000+3
+				       , 17*70000, 17*3, 17*40000 } ;
+  unsigned long p ;
+  int i, j ;
+  volatile int t ;
+
+  s = open_bitstream("xxx", "w") ;
+  for(i=0; i<100000; i++)
+    put_bits(s, 17, i) ;
+  close_bitstream(s) ;
+
+  for(j=0; j<3; j++)
+    {
+      switch(j)
+	{
+	case 0: s = open_bitstream("xxx", "r") ; break ;
+	case 1: s = open_bitstream_mmap("xxx", "r") ; break ;
+	default:
+	  s = open_bitstream("xxx", "r") ;
+	  get_bits(s, 17) ;
+	  break ;
+	}
+      for(i=0; i<TAILLE(positions); i++)
+	{
+	  p = positions[i] ;
+	  bitstream_seek_bits(s, p) ;
+	  if ( bitstream_tell_bits(s) != p )
+	    {
+	      eprintf("Après seek(%lu) on est en %lu\n"
+		      , p, bitstream_tell_bits(s)) ;
+	      return ;
+	    }
+	  if ( p % 17 == 0 && get_bits(s, 17) != p / 17 )
+	    {
+	      eprintf("Mauvaise valeur lue après seek(%lu) (cas %d)\n", p, j) ;
+	      return ;
+	    }
+	  if ( p % 17 == 3 && get_bits(s, 14) != (p / 17) % (1<<14) )
+	    {
+	      eprintf("Mauvaise valeur lue après seek(%lu) (cas %d)\n", p, j) ;
+	      return ;
+	    }
+	}
+      t = 0 ;
+      EXCEPTION(bitstream_seek_bits(s, 17*100000 + 8) ;
+		get_bits(s, 8) ;
+		,
+		,
+		case Exception_fichier_lecture:
+		t = 1 ;
+		break ;
+		) ;
+      if ( t == 0 )
+	{
+	  eprintf("Pas d'exception en lisant après un seek hors du flot\n") ;
+	  return ;
+	}
+      close_bitstream(s) ;
+    }
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  t = 0 ;
+  EXCEPTION(bitstream_seek_bits(s, 0) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Pas de seek sur un flot ouvert en écriture\n") ;
+      return ;
+    }
+  free(close_bitstream_memory(s, NULL)) ;
+}
+
+void open_bitstream_sous_flot_tst()
+{
+  struct bitstream *s, *sous ;
+  unsigned char zone[4] = { 0x12, 0x34, 0x56, 0x78 } ;
+  volatile int t ;
+
+  s = open_bitstream_memory(zone, sizeof(zone), "r") ;
+  sous = open_bitstream_sous_flot(s, 1, 2) ;
+  if ( get_bits(sous, 16) != 0x3456 )
+    {
+      eprintf("Le sous flot ne lit pas les bons octets\n") ;
+      return ;
+    }
+  t = 0 ;
+  EXCEPTION(get_bit(sous) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Le sous flot ne doit pas lire après sa fin\n") ;
+      return ;
+    }
+  close_bitstream(sous) ;
+  if ( get_bits(s, 8) != 0x12 )
+    {
+      eprintf("Le sous flot ne doit pas changer la position du flot\n") ;
+      return ;
+    }
+  t = 0 ;
+  EXCEPTION(open_bitstream_sous_flot(s, 3, 2) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Un sous flot qui déborde doit lancer une exception\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+
+  s = open_bitstream("xxx", "r") ;
+  t = 0 ;
+  EXCEPTION(open_bitstream_sous_flot(s, 0, 1) ;
+	    ,
+	    ,
+	    case Exception_fichier_positionnement:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Un sous flot d'un fichier lu par fread est impossible\n") ;
+      return ;
+    }
+  close_bitstream(s) ;
+}
+
+void bitstream_statistiques_tst()
+{
+  struct bitstream *s ;
+  unsigned char zone[10] ;
+  char ligne[200] ;
+  FILE *json ;
+
+  json = tmpfile() ;
+  s = open_bitstream_memory(zone, sizeof(zone), "w") ;
+  bitstream_statistiques(s, json, "essai") ;
+  put_bits(s, 13, 0x1234) ;
+  close_bitstream(s) ;
+  s = open_bitstream_memory(zone, sizeof(zone), "rL") ;
+  bitstream_statistiques(s, json, "relu") ;
+  get_bits(s, 5) ;
+  close_bitstream(s) ;
+
+  rewind(json) ;
+  if ( fgets(ligne, sizeof(ligne), json) == NULL
+       || strcmp(ligne, "{\"bitstream\": \"essai\", \"type\": \"memoire\""
+		 ", \"mode\": \"ecriture\", \"ordre\": \"msb\""
+		 ", \"bits\": 13, \"octets\": 2}\n") )
+    {
+      eprintf("Mauvaise statistique en écriture : %s\n", ligne) ;
+      return ;
+    }
+  if ( fgets(ligne, sizeof(ligne), json) == NULL
+       || strcmp(ligne, "{\"bitstream\": \"relu\", \"type\": \"memoire\""
+		 ", \"mode\": \"lecture\", \"ordre\": \"lsb\""
+		 ", \"bits\": 5, \"octets\": 1}\n") )
+    {
+      eprintf("Mauvaise statistique en lecture : %s\n", ligne) ;
+      return ;
+    }
+  if ( fgets(ligne, sizeof(ligne), json) != NULL )
+    {
+      eprintf("Une seule ligne par flot fermé\n") ;
+      return ;
+    }
+  fclose(json) ;
+}
+
+/*
+ * Lecture après la fin dans un fil d'exécution sans récupération
+ * "EXCEPTION" : get_bits retourne 0 et l'erreur est sur le flot.
+ * Puis la même chose avec une récupération propre au fil.
+ */
+
+static void *lit_apres_la_fin(void *arg)
+{
+  static unsigned char zone[] = { 0x12, 0x34 } ;
+  struct bitstream *s ;
+  int *resultat = arg ;
+
+  s = open_bitstream_memory(zone, sizeof(zone), "r") ;
+  resultat[0] = get_bits(s, 8) == 0x12 && bitstream_erreur(s) == 0 ;
+  get_bits(s, 8) ;
+  resultat[1] = get_bits(s, 8) == 0
+    && bitstream_erreur(s) == Exception_fichier_lecture ;
+  put_bit(s, 1) ;
+  resultat[2] = bitstream_erreur(s)
+    == Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture ;
+  close_bitstream(s) ;
+
+  resultat[3] = 0 ;
+  s = open_bitstream_memory(zone, sizeof(zone), "r") ;
+  EXCEPTION(get_bits(s, 16) ; get_bits(s, 1) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    resultat[3] = 1 ;
+	    break ;
+	    ) ;
+  close_bitstream(s) ;
+  return NULL ;
+}
+
+void bitstream_erreur_tst()
+{
+  pthread_t fils[4] ;
+  int resultats[4][4], i, j ;
+
+  for(i=0; i<4; i++)
+    pthread_create(&fils[i], NULL, lit_apres_la_fin, resultats[i]) ;
+  for(i=0; i<4; i++)
+    pthread_join(fils[i], NULL) ;
+  for(i=0; i<4; i++)
+    for(j=0; j<4; j++)
+      if ( !resultats[i][j] )
+	{
+	  eprintf("Fil %d, vérification %d : mauvaise erreur sur le flot\n"
+		  , i, j) ;
+	  return ;
+	}
+}
+
+static void *signale_sans_recuperation(void *arg)
+{
+  struct bitstream *s ;
+  int *resultat = arg ;
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  bitstream_signale(s, Exception_marqueur_segment_invalide) ;
+  *resultat = bitstream_erreur(s) == Exception_marqueur_segment_invalide ;
+  free(close_bitstream_memory(s, NULL)) ;
+  return NULL ;
+}
+
+void bitstream_signale_tst()
+{
+  struct bitstream *s ;
+  pthread_t fil ;
+  int t ;
+
+  t = 0 ;
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  EXCEPTION(bitstream_signale(s, Exception_marqueur_segment_invalide) ;
+	    ,
+	    ,
+	    case Exception_marqueur_segment_invalide:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 || bitstream_erreur(s) != Exception_marqueur_segment_invalide )
+    {
+      eprintf("Avec une récupération en cours, l'exception doit être lancée\n") ;
+      return ;
+    }
+  free(close_bitstream_memory(s, NULL)) ;
+
+  t = 0 ;
+  pthread_create(&fil, NULL, signale_sans_recuperation, &t) ;
+  pthread_join(fil, NULL) ;
+  if ( t == 0 )
+    {
+      eprintf("Sans récupération, l'erreur doit être gardée par le flot\n") ;
+      return ;
+    }
+}
+
+/*
+ * Le CRC calculé au fil de l'écriture (fichier de plusieurs tampons)
+ * et de la relecture doit être celui des octets du fichier.
+ */
+
+void bitstream_crc_debut_tst()
+{
+  static const char *versions[] = { "base", "sse42" } ;
+  struct bitstream *s ;
+  unsigned char *octets ;
+  unsigned int crc, crc_lu, attendu ;
+  int i, v, n ;
+  FILE *f ;
+
+  for(v=0; v<TAILLE(versions); v++)
+    {
+      if ( !crc_force(versions[v]) )
+	continue ;
+      if ( crc32c(0, "123456789", 9) != 0xE3069283
+	   || crc32c(crc32c(0, "1234", 4), "56789", 5) != 0xE3069283 )
+	{
+	  eprintf("Version %s : mauvais CRC32C de \"123456789\"\n"
+		  , versions[v]) ;
+	  return ;
+	}
+
+      s = open_bitstream("xxx", "w") ;
+      put_bits(s, 3, 5) ;
+      bitstream_crc_debut(s) ;
+      for(i=0; i<3*TAILLE_TAMPON_BITSTREAM; i++)
+	put_bits(s, 7, i * 13) ;
+      if ( !bitstream_crc_fin(s, &crc) )
+	{
+	  eprintf("bitstream_crc_fin doit indiquer un CRC en cours\n") ;
+	  return ;
+	}
+      put_bits(s, 32, crc) ;
+      close_bitstream(s) ;
+
+      f = fopen("xxx", "r") ;
+      ALLOUER(octets, 4 * TAILLE_TAMPON_BITSTREAM) ;
+      n = fread(octets, 1, 4 * TAILLE_TAMPON_BITSTREAM, f) ;
+      fclose(f) ;
+      attendu = crc32c(0, octets + 1, n - 5) ;
+      free(octets) ;
+      if ( crc != attendu )
+	{
+	  eprintf("Version %s : CRC en écriture %08x au lieu de %08x\n"
+		  , versions[v], crc, attendu) ;
+	  return ;
+	}
+
+      s = open_bitstream("xxx", "r") ;
+      get_bits(s, 3) ;
+      bitstream_crc_debut(s) ;
+      for(i=0; i<3*TAILLE_TAMPON_BITSTREAM; i++)
+	if ( get_bits(s, 7) != ((i * 13) & 0x7F) )
+	  {
+	    eprintf("Le CRC ne doit pas changer la lecture\n") ;
+	    return ;
+	  }
+      bitstream_crc_fin(s, &crc_lu) ;
+      if ( crc_lu != attendu || get_bits(s, 32) != attendu )
+	{
+	  eprintf("Version %s : CRC en lecture %08x au lieu de %08x\n"
+		  , versions[v], crc_lu, attendu) ;
+	  return ;
+	}
+      close_bitstream(s) ;
+    }
+  crc_force(NULL) ;
+}
+
+void bitstream_crc_fin_tst()
+{
+  struct bitstream *s ;
+  unsigned char *zone ;
+  unsigned int crc ;
+  size_t taille ;
+
+  s = open_bitstream_memory(NULL, 0, "w") ;
+  if ( bitstream_crc_fin(s, &crc) )
+    {
+      eprintf("Sans bitstream_crc_debut, il n'y a pas de CRC\n") ;
+      return ;
+    }
+  bitstream_crc_debut(s) ;
+  put_bits(s, 12, 0x123) ;		/* Complété par 4 bits à 0 */
+  bitstream_crc_fin(s, &crc) ;
+  if ( crc != crc32c(0, "\x12\x30", 2) )
+    {
+      eprintf("Le CRC doit porter sur les octets complétés\n") ;
+      return ;
+    }
+  if ( bitstream_crc_fin(s, &crc) )
+    {
+      eprintf("bitstream_crc_fin arrête le calcul\n") ;
+      return ;
+    }
+  zone = close_bitstream_memory(s, &taille) ;
+  if ( taille != 2 )
+    {
+      eprintf("Le CRC n'écrit rien dans le flot\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+void bitstream_lsb_tst()
+{
+  static const char *modes[] = { "w", "wl", "wL" } ;
+  struct bitstream *s ;
+  int i ;
+
+  for(i=0; i<TAILLE(modes); i++)
+    {
+      s = open_bitstream_memory(NULL, 0, modes[i]) ;
+      if ( bitstream_lsb(s) != (i != 0) )
+	{
+	  eprintf("Mauvais ordre des bits pour le mode \"%s\"\n", modes[i]) ;
+	  return ;
+	}
+      free(close_bitstream_memory(s, NULL)) ;
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * CRC32C (voir "crc.h").
+ *
+ * Il y a deux versions :
+ *    - "base" : la méthode "slicing-by-8", 8 tables de 256 entiers
+ *      permettent de traiter 8 octets par tour de boucle.
+ *    - "sse42" : l'instruction "crc32" traite 8 octets en un cycle.
+ * Comme dans "vecteur.c", la meilleure version est choisie
+ * à la première utilisation grâce à l'attribut "target".
+ */
+
+#include <stdint.h>
+#include <pthread.h>
+#include "bases.h"
+#include "crc.h"
+
+#ifdef PROCESSEUR_X86
+#include <immintrin.h>
+#endif
+
+#define POLYNOME 0x82F63B78	/* Castagnoli, bits inversés */
+
+typedef unsigned int (*Crc)(unsigned int, const unsigned char *, size_t) ;
+
+static uint32_t table[8][256] ;
+
+static void initialise_table(void)
+{
+  uint32_t c ;
+  int i, j ;
+
+  for(i=0; i<256; i++)
+    {
+      c = i ;
+      for(j=0; j<8; j++)
+	c = c & 1 ? (c >> 1) ^ POLYNOME : c >> 1 ;
+      table[0][i] = c ;
+    }
+  for(i=0; i<256; i++)
+    for(j=1; j<8; j++)
+      table[j][i] = (table[j-1][i] >> 8) ^ table[0][table[j-1][i] & 0xFF] ;
+}
+
+static unsigned int crc_base(unsigned int crc, const unsigned char *o
+			     , size_t n)
+{
+  uint32_t c, bas, haut ;
+
+  c = crc ;
+  for( ; n >= 8 ; n -= 8, o += 8)
+    {
+      bas = c ^ (o[0] | o[1] << 8 | o[2] << 16 | (uint32_t)o[3] << 24) ;
+      haut = o[4] | o[5] << 8 | o[6] << 16 | (uint32_t)o[7] << 24 ;
+      c = table[7][bas & 0xFF] ^ table[6][(bas >> 8) & 0xFF]
+	^ table[5][(bas >> 16) & 0xFF] ^ table[4][bas >> 24]
+	^ table[3][haut & 0xFF] ^ table[2][(haut >> 8) & 0xFF]
+	^ table[1][(haut >> 16) & 0xFF] ^ table[0][haut >> 24] ;
+    }
+  while( n-- )
+    c = table[0][(c ^ *o++) & 0xFF] ^ (c >> 8) ;
+  return c ;
+}
+
+#ifdef PROCESSEUR_X86
+
+__attribute__((target("sse4.2")))
+static unsigned int crc_sse42(unsigned int crc, const unsigned char *o
+			      , size_t n)
+{
+#ifdef __x86_64__
+  uint64_t c, v ;
+
+  c = crc ;
+  for( ; n >= 8 ; n -= 8, o += 8)
+    {
+      memcpy(&v, o, sizeof(v)) ;
+      c = _mm_crc32_u64(c, v) ;
+    }
+#else
+  uint32_t c, v ;			/* Pas de "crc32" 64 bits en 32 bits */
+
+  c = crc ;
+  for( ; n >= 4 ; n -= 4, o += 4)
+    {
+      memcpy(&v, o, sizeof(v)) ;
+      c = _mm_crc32_u32(c, v) ;
+    }
+#endif
+  while( n-- )
+    c = _mm_crc32_u8(c, *o++) ;
+  return c ;
+}
+
+#endif
+
+static Crc version ;
+static pthread_once_t version_choisie = PTHREAD_ONCE_INIT ;
+
+static int choisit(const char *nom)
+{
+#ifdef PROCESSEUR_X86
+  __builtin_cpu_init() ;
+  if ( (nom == NULL || strcmp(nom, "sse42") == 0)
+       && __builtin_cpu_supports("sse4.2") )
+    {
+      version = crc_sse42 ;
+      return 1 ;
+    }
+#endif
+  if ( nom == NULL || strcmp(nom, "base") == 0 )
+    {
+      if ( table[0][1] == 0 )
+	initialise_table() ;
+      version = crc_base ;
+      return 1 ;
+    }
+  return 0 ;
+}
+
+static void choisit_meilleure(void)
+{
+  choisit(NULL) ;
+}
+
+/*
+ * Force une version ("base" ou "sse42"), NULL pour la meilleure.
+ * Retourne 0 si le processeur ne sait pas faire (rien ne change).
+ * Sans appel, la meilleure est choisie une seule fois
+ * à la première utilisation, même par plusieurs fils d'exécution.
+ *
+ * Pour les tests seulement : le pointeur change sans synchronisation,
+ * pas d'appel pendant que d'autres fils utilisent ces fonctions.
+ */
+
+int crc_force(const char *nom)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return choisit(nom) ;
+}
+
+unsigned int crc32c(unsigned int crc, const void *octets, size_t n)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return ~(*version)(~crc, octets, n) ;
+}
@@ -0,0 +1,20 @@
+#ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_CRC_H
+#define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_CRC_H
+
+#include <stddef.h>
+
+/*
+ * CRC32C (polynôme de Castagnoli) des "n" octets,
+ * pour vérifier l'intégrité des flots archivés.
+ * On commence avec "crc" égal à 0 et on enchaîne les morceaux :
+ *      crc32c(crc32c(0, a, na), b, nb) == CRC de "a" suivi de "b"
+ * Par exemple, crc32c(0, "123456789", 9) == 0xE3069283
+ *
+ * Sur x86 on utilise l'instruction "crc32" de SSE4.2 si le processeur
+ * la connaît, sinon une table (8 octets à la fois).
+ */
+
+unsigned int crc32c(unsigned int crc, const void *octets, size_t n) ;
+int          crc_force(const char *nom) ;
+
+#endif
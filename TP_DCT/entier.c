@@ -1,5 +1,8 @@
+#include <pthread.h>
 #include "bits.h"
 #include "entier.h"
+#include "exception.h"
+#include "vecteur.h"
 
 /*
  * Les fonctions de ce fichier permette d'encoder et de décoder
@@ -39,81 +42,134 @@ static char *prefixes[] = { "00", "010", "011", "1000", "1001", "1010", "1011",
 			    "11000", "11001", "11010", "11011", "11100",
 			    "11101", "11110", "111110", "111111" } ;
 
-void put_entier(struct bitstream *b, unsigned int f)
+/*
+ * Les tables sont calculées une fois pour toutes par le premier
+ * fil d'exécution qui en a besoin. Il y en a une par ordre des bits
+ * ("ordre" vaut 1 pour un flot LSB, voir "bitstream_lsb").
+ *
+ * Ecriture : "codes[ordre][f]" contient le code complet de "f"
+ * (préfixe puis suffixe) décalé de BITS_LONGUEUR bits et sa longueur,
+ * on l'écrit en un seul "put_bits".
+ * Dans un flot LSB, "put_bits" sort d'abord le poids faible :
+ * le préfixe est donc rangé à l'envers dans les bits de poids faible
+ * et le suffixe au-dessus.
+ *
+ * Lecture : on regarde les LONGUEUR_MAX prochains bits ("peek_bits"),
+ * les PREFIXE_MAX premiers donnent dans "prefixe[ordre]" le nombre
+ * de bits du nombre et la longueur du préfixe.
+ * On extrait le suffixe et on consomme tout le code d'un coup.
+ */
+
+#define NB_ENTIERS     32768
+#define PREFIXE_MAX    6		/* Le plus long préfixe */
+#define LONGUEUR_MAX   20		/* Le plus long code */
+#define BITS_LONGUEUR  5
+#define CODE(C)        ((C) >> BITS_LONGUEUR)
+#define LONGUEUR(C)    ((C) & ((1 << BITS_LONGUEUR) - 1))
+
+static unsigned int codes[2][NB_ENTIERS] ;
+static struct
 {
-	if(f > 32767)
-		EXIT;
-	unsigned int nb_bits = nb_bits_utile(f);
-	unsigned long diff = f - pow2(nb_bits-1);
-
-	if (nb_bits > 1){
-		char* suffixe = (char*) malloc(nb_bits);
-		for(unsigned int i=0; i< nb_bits-1 ; i++ )
-		{
-			if(prend_bit(diff,nb_bits - i -2))
-				suffixe[i] = '1';
-			else
-		  	suffixe[i] = '0';
-		}
-		suffixe[nb_bits-1] ='\0' ;
-		char* str = (char*) malloc( strlen(prefixes[nb_bits]) + strlen(suffixe) +1);
-		strcpy(str,prefixes[nb_bits]);
-		strcat(str,suffixe);
-		str[strlen(str)]='\0';
-		put_bit_string(b,str);
-
-		free(str);
-		free(suffixe);
-	}
-	else{
-		put_bit_string(b,prefixes[nb_bits]);
+  unsigned char nb_bits ;		/* Indice dans "prefixes" */
+  unsigned char longueur ;		/* Longueur du préfixe */
+} prefixe[2][1 << PREFIXE_MAX] ;
+static pthread_once_t tables_calculees = PTHREAD_ONCE_INIT ;
+
+static unsigned int inverse_bits(unsigned int v, unsigned int nb)
+{
+  unsigned int r ;
+
+  for(r=0; nb--; v >>= 1)
+    r = r << 1 | (v & 1) ;
+  return r ;
+}
+
+static void calcule_tables(void)
+{
+  unsigned int f, nb_bits, p, longueur, suffixe, s, i ;
+
+  for(nb_bits=0; nb_bits<TAILLE(prefixes); nb_bits++)
+    {
+      p = strtol(prefixes[nb_bits], NULL, 2) ;
+      longueur = strlen(prefixes[nb_bits]) ;
+      /* Toutes les suites de PREFIXE_MAX bits qui commencent par "p" */
+      for(i=0; i < 1u << (PREFIXE_MAX - longueur); i++)
+	{
+	  s = p << (PREFIXE_MAX - longueur) | i ;
+	  prefixe[0][s].nb_bits = nb_bits ;
+	  prefixe[0][s].longueur = longueur ;
+	  prefixe[1][inverse_bits(s, PREFIXE_MAX)] = prefixe[0][s] ;
 	}
+    }
+  for(f=0; f<NB_ENTIERS; f++)
+    {
+      nb_bits = nb_bits_utile(f) ;
+      p = strtol(prefixes[nb_bits], NULL, 2) ;
+      longueur = strlen(prefixes[nb_bits]) ;
+      /* Le suffixe : les bits sous le premier 1 */
+      suffixe = nb_bits > 1 ? nb_bits - 1 : 0 ;
+      s = f & (pow2(suffixe) - 1) ;
+      codes[0][f] = (p << suffixe | s) << BITS_LONGUEUR
+	| (longueur + suffixe) ;
+      codes[1][f] = (inverse_bits(p, longueur) | s << longueur)
+	<< BITS_LONGUEUR | (longueur + suffixe) ;
+    }
+}
+
+static inline unsigned int code_entier(struct bitstream *b, unsigned int f)
+{
+  if ( f >= NB_ENTIERS )
+    EXIT ;
+  pthread_once(&tables_calculees, calcule_tables) ;
+  return codes[bitstream_lsb(b)][f] ;
+}
 
+void put_entier(struct bitstream *b, unsigned int f)
+{
+  unsigned int c ;
+
+  c = code_entier(b, f) ;
+  put_bits(b, LONGUEUR(c), CODE(c)) ;
 }
 
 /*
  * Cette fonction fait l'inverse de la précédente.
  *
- * Un implémentation propre, extensible serait d'utiliser
- * un arbre binaire comme pour le décodage d'Huffman.
- * Ou bien parcourir l'arbre des états 8 bits par 8 bits (voir le cours)
- * Mais je ne vous le demande pas
+ * "v" contient les LONGUEUR_MAX prochains bits du flot,
+ * on retourne l'entier qui est au début et on range dans "*longueur"
+ * le nombre de bits de son code.
  */
 
+static inline unsigned int decode(unsigned long v, Booleen lsb
+				  , unsigned int *longueur)
+{
+  unsigned int i, nb_bits, suffixe, s ;
+
+  if ( lsb )
+    i = v & ((1 << PREFIXE_MAX) - 1) ;
+  else
+    i = v >> (LONGUEUR_MAX - PREFIXE_MAX) ;
+  nb_bits = prefixe[lsb][i].nb_bits ;
+  *longueur = prefixe[lsb][i].longueur ;
+  if ( nb_bits < 2 )
+    return nb_bits ;
+  suffixe = nb_bits - 1 ;
+  if ( lsb )
+    s = v >> *longueur ;
+  else
+    s = v >> (LONGUEUR_MAX - *longueur - suffixe) ;
+  *longueur += suffixe ;
+  return (1u << suffixe) | (s & ((1u << suffixe) - 1)) ;
+}
+
 unsigned int get_entier(struct bitstream *b)
 {
+  unsigned int v, longueur ;
 
-	char* comp = (char*) malloc(7);
-	for(int i=0; i<7; i++)
-	{
-		comp[i] = '\0';
-	}
-  unsigned int value = -1;
-
-	for(unsigned int i=0; i<6 ; i++){
-		if(get_bit(b))
-			comp[i]='1';
-		else
-			comp[i]='0';
-		for(int j=0; j<16; j++)
-			{
-				if(strcmp(prefixes[j],comp) == 0){
-							 value = j;
-							 break;
-					}
-			}
-			if(value != -1){
-					break;
-			}
-	}
-	free(comp);
-	if(value < 2)
-		return value;
-	else
-	{
-		unsigned int val = get_bits(b,value-1) + pow2(value-1);
-		return val;
-	} /* pour enlever un warning du compilateur */
+  pthread_once(&tables_calculees, calcule_tables) ;
+  v = decode(peek_bits(b, LONGUEUR_MAX), bitstream_lsb(b), &longueur) ;
+  skip_bits(b, longueur) ;
+  return v ;
 }
 
 /*
@@ -129,25 +185,503 @@ unsigned int get_entier(struct bitstream *b)
  *   -2 --> 1 1
  *   -3 --> 1 2
  *
+ * Le bit de signe est ajouté devant le code de la table :
+ * on écrit et on lit le tout en une seule fois.
  */
 
 void put_entier_signe(struct bitstream *b, int i)
 {
-		if(i >= 0)
-		{
-			put_bit(b,Faux);
-			put_entier(b,i);
-		}
-		else
-		{
-			put_bit(b,Vrai);
-			put_entier(b,-i-1);
-		}
+  unsigned int c, signe ;
+
+  signe = i < 0 ;
+  c = code_entier(b, signe ? -(i+1) : i) ;
+  if ( bitstream_lsb(b) )
+    put_bits(b, LONGUEUR(c) + 1, (unsigned long)CODE(c) << 1 | signe) ;
+  else
+    put_bits(b, LONGUEUR(c) + 1
+	     , (unsigned long)signe << LONGUEUR(c) | CODE(c)) ;
 }
+
+int get_entier_signe(struct bitstream *b)
+{
+  unsigned long v ;
+  unsigned int f, longueur, signe ;
+  Booleen lsb ;
+
+  pthread_once(&tables_calculees, calcule_tables) ;
+  lsb = bitstream_lsb(b) ;
+  v = peek_bits(b, LONGUEUR_MAX + 1) ;
+  if ( lsb )
+    {
+      signe = v & 1 ;
+      v >>= 1 ;
+    }
+  else
+    {
+      signe = v >> LONGUEUR_MAX ;
+      v &= (1ul << LONGUEUR_MAX) - 1 ;
+    }
+  f = decode(v, lsb, &longueur) ;
+  skip_bits(b, longueur + 1) ;
+  return signe ? -(int)f - 1 : (int)f ;
+}
+
 /*
+ * Codes universels : ils codent tous les entiers de 0 à 2^64-1.
  *
+ * Exp-Golomb d'ordre "k" : soit w = v + 2^k sur "n" bits (jusqu'à 65),
+ * on écrit n-k-1 zéros, le 1 de tête de w puis ses n-1 autres bits.
+ *    k=0 : 0 --> 1     1 --> 010     2 --> 011     3 --> 00100
+ *    k=2 : 0 --> 100   3 --> 111     4 --> 01000   11 --> 01111
+ *
+ * Elias gamma : c'est Exp-Golomb d'ordre 0 (le code gamma de v+1).
+ *
+ * Elias delta : soit w = v + 1 sur "n" bits, on écrit n-1 en
+ * Elias gamma puis les n-1 bits de w après le 1 de tête.
+ *    0 --> 1     1 --> 0100     2 --> 0101     3 --> 01100
+ *
+ * Dans un flot LSB les zéros et le 1 sont dans le même ordre,
+ * les bits qui suivent sont écrits par "put_bits" (poids faible en
+ * premier) comme tous les champs de taille fixe.
+ *
+ * Le nombre de zéros en tête se compte en une instruction
+ * ("nb_zeros_gauche" ou "__builtin_ctzl" suivant l'ordre des bits)
+ * sur une fenêtre de FENETRE bits regardée par "peek_bits".
+ * Si le code tient dans la fenêtre, il est écrit par un seul
+ * "put_bits" et lu par un seul "skip_bits".
  */
-int get_entier_signe(struct bitstream *b)
+
+#define FENETRE        56	/* Bits toujours disponibles pour "peek_bits" */
+#define BITS_LONG      (8 * sizeof(unsigned long))
+#define MASQUE(N)      ((N) ? ~0ul >> (BITS_LONG - (N)) : 0ul)
+#define TETE(N)        ((N) < BITS_LONG ? 1ul << (N) : 0ul)
+
+/*
+ * Ecrit "nb_zeros" zéros, un 1 puis les "nb" bits de droite de "v".
+ */
+
+static void put_code(struct bitstream *b, unsigned int nb_zeros
+		     , unsigned int nb, unsigned long v)
+{
+  if ( nb_zeros + 1 + nb <= NB_BITS )
+    {
+      if ( bitstream_lsb(b) )
+	put_bits(b, nb_zeros + 1 + nb, (v << 1 | 1) << nb_zeros) ;
+      else
+	put_bits(b, nb_zeros + 1 + nb, TETE(nb) | (v & MASQUE(nb))) ;
+      return ;
+    }
+  put_bits(b, nb_zeros, 0) ;
+  put_bit(b, Vrai) ;
+  put_bits(b, nb, v) ;
+}
+
+/*
+ * Nombre de zéros en tête des FENETRE bits de "v" (non nul)
+ */
+
+static inline unsigned int zeros_en_tete(unsigned long v, Booleen lsb)
+{
+  if ( lsb )
+    return __builtin_ctzl(v) ;
+  return nb_zeros_gauche(v) - (BITS_LONG - FENETRE) ;
+}
+
+/*
+ * Lit les zéros et le 1 qui les suit, retourne le nombre de zéros.
+ * Plus de 64 zéros ne peuvent venir que d'un flot corrompu :
+ * on signale alors une erreur de lecture.
+ */
+
+static unsigned int lit_zeros(struct bitstream *b)
 {
-	return  get_bit(b) ? -get_entier(b) -1 : get_entier(b) ; /* pour enlever un warning du compilateur */
+  unsigned long v ;
+  unsigned int nb_zeros, z ;
+
+  for(nb_zeros = 0 ; ; nb_zeros += FENETRE)
+    {
+      v = peek_bits(b, FENETRE) ;
+      if ( v )
+	break ;
+      if ( nb_zeros > BITS_LONG || bitstream_erreur(b) )
+	{
+	  bitstream_signale(b, Exception_fichier_lecture) ;
+	  return 0 ;
+	}
+      skip_bits(b, FENETRE) ;
+    }
+  z = zeros_en_tete(v, bitstream_lsb(b)) ;
+  skip_bits(b, z + 1) ;
+  return nb_zeros + z ;
+}
+
+/*
+ * Lit "nb" bits (jusqu'à 64) en deux fois si nécessaire.
+ */
+
+static unsigned long lit_bits(struct bitstream *b, unsigned int nb)
+{
+  unsigned long v, w ;
+
+  if ( nb <= FENETRE )
+    {
+      v = peek_bits(b, nb) ;
+      skip_bits(b, nb) ;
+      return v ;
+    }
+  v = lit_bits(b, nb - 32) ;
+  w = lit_bits(b, 32) ;
+  if ( bitstream_lsb(b) )
+    return w << (nb - 32) | v ;
+  return v << 32 | w ;
+}
+
+void put_exp_golomb(struct bitstream *b, unsigned int k, unsigned long v)
+{
+  unsigned long w ;
+  unsigned int n ;
+
+  if ( k >= BITS_LONG )
+    EXIT ;
+  w = v + TETE(k) ;
+  n = w < v ? BITS_LONG + 1 : nb_bits_utile(w) ; /* Retenue : 65 bits */
+  put_code(b, n - k - 1, n - 1, w) ;
+}
+
+unsigned long get_exp_golomb(struct bitstream *b, unsigned int k)
+{
+  unsigned long v ;
+  unsigned int z, n ;
+  Booleen lsb ;
+
+  if ( k >= BITS_LONG )
+    EXIT ;
+  lsb = bitstream_lsb(b) ;
+  v = peek_bits(b, FENETRE) ;
+  if ( v )
+    {
+      z = zeros_en_tete(v, lsb) ;
+      n = 2 * z + k + 1 ;		/* Longueur du code */
+      if ( n <= FENETRE )
+	{
+	  skip_bits(b, n) ;
+	  if ( lsb )
+	    v >>= z + 1 ;
+	  else
+	    v >>= FENETRE - n ;
+	  return (TETE(z + k) | (v & MASQUE(z + k))) - TETE(k) ;
+	}
+    }
+  z = lit_zeros(b) ;
+  if ( bitstream_erreur(b) )
+    return 0 ;
+  if ( z + k > BITS_LONG )
+    {
+      bitstream_signale(b, Exception_fichier_lecture) ;
+      return 0 ;
+    }
+  v = lit_bits(b, z + k) ;
+  if ( bitstream_erreur(b) )
+    return 0 ;
+  return (TETE(z + k) | v) - TETE(k) ;
+}
+
+void put_elias_gamma(struct bitstream *b, unsigned long v)
+{
+  put_exp_golomb(b, 0, v) ;
+}
+
+unsigned long get_elias_gamma(struct bitstream *b)
+{
+  return get_exp_golomb(b, 0) ;
+}
+
+void put_elias_delta(struct bitstream *b, unsigned long v)
+{
+  unsigned long w ;
+  unsigned int n ;
+
+  w = v + 1 ;
+  n = w ? nb_bits_utile(w) : BITS_LONG + 1 ;
+  put_exp_golomb(b, 0, n - 1) ;
+  put_bits(b, n - 1, w) ;
+}
+
+unsigned long get_elias_delta(struct bitstream *b)
+{
+  unsigned long n, v ;
+
+  n = get_exp_golomb(b, 0) ;
+  if ( bitstream_erreur(b) )
+    return 0 ;
+  if ( n > BITS_LONG )
+    {
+      bitstream_signale(b, Exception_fichier_lecture) ;
+      return 0 ;
+    }
+  v = lit_bits(b, n) ;
+  if ( bitstream_erreur(b) )
+    return 0 ;
+  return (TETE(n) | v) - 1 ;
+}
+
+/*
+ * Codes de Rice de paramètre "k" (de 0 à 63) : le quotient q = v >> k
+ * est écrit en unaire (q zéros puis un 1), suivi des "k" bits de droite
+ * de "v".
+ *    k=0 : 0 --> 1     1 --> 01      2 --> 001
+ *    k=2 : 0 --> 100   3 --> 111     4 --> 0100    9 --> 00101
+ *
+ * Un quotient d'au moins LIMITE_RICE est écrit comme LIMITE_RICE zéros
+ * suivis de q-LIMITE_RICE en Elias gamma puis des "k" bits :
+ * un code ne dépasse jamais LIMITE_RICE + 129 + k bits.
+ */
+
+#define LIMITE_RICE    32	/* Inférieur à FENETRE */
+
+void put_rice(struct bitstream *b, unsigned int k, unsigned long v)
+{
+  unsigned long q ;
+
+  if ( k >= BITS_LONG )
+    EXIT ;
+  q = v >> k ;
+  if ( q < LIMITE_RICE )
+    {
+      put_code(b, q, k, v) ;
+      return ;
+    }
+  put_bits(b, LIMITE_RICE, 0) ;
+  put_elias_gamma(b, q - LIMITE_RICE) ;
+  put_bits(b, k, v) ;
+}
+
+unsigned long get_rice(struct bitstream *b, unsigned int k)
+{
+  unsigned long v, q ;
+  unsigned int z ;
+  Booleen lsb ;
+
+  if ( k >= BITS_LONG )
+    EXIT ;
+  lsb = bitstream_lsb(b) ;
+  v = peek_bits(b, FENETRE) ;
+  z = v ? zeros_en_tete(v, lsb) : FENETRE ;
+  if ( z < LIMITE_RICE && z + 1 + k <= FENETRE )
+    {
+      skip_bits(b, z + 1 + k) ;
+      if ( lsb )
+	v >>= z + 1 ;
+      else
+	v >>= FENETRE - (z + 1 + k) ;
+      return (unsigned long)z << k | (v & MASQUE(k)) ;
+    }
+  if ( z < LIMITE_RICE )
+    {
+      skip_bits(b, z + 1) ;
+      q = z ;
+    }
+  else
+    {
+      skip_bits(b, LIMITE_RICE) ;
+      q = LIMITE_RICE + get_elias_gamma(b) ;
+    }
+  v = lit_bits(b, k) ;
+  /* Comme "lit_zeros" : rien de vraisemblable après une erreur */
+  if ( bitstream_erreur(b) )
+    return 0 ;
+  return q << k | v ;
+}
+
+/*
+ * Codage de tableaux d'entiers signés.
+ *
+ * Les entiers sont entrelacés par paquets de TAILLE_PAQUET
+ * avec "entrelace_signes" (SIMD) : le bit de droite est le signe
+ * et les autres la magnitude. Les codes sont concaténés dans
+ * un accumulateur de 64 bits qui est écrit par un seul "put_bits"
+ * quand il est plein : un appel pour plusieurs entiers.
+ * Le flot produit est identique à celui des fonctions entier par entier.
+ *
+ * Seuls l'entrelacement et, pour Exp-Golomb, le calcul des longueurs
+ * ("nb_bits_utile_tableau") sont vectoriels. Au décodage, la position
+ * d'un code dépend de la longueur des précédents : les codes sont lus
+ * un par un, seul le désentrelacement travaille sur le paquet.
+ */
+
+#define TAILLE_PAQUET 256
+
+struct accumulateur
+{
+  unsigned long bits ;
+  unsigned int nb ;
+  Booleen lsb ;
+} ;
+
+static inline void accumule(struct bitstream *b, struct accumulateur *a
+			    , unsigned int nb, unsigned long code)
+{
+  if ( a->nb + nb > NB_BITS )
+    {
+      put_bits(b, a->nb, a->bits) ;
+      a->bits = 0 ;
+      a->nb = 0 ;
+    }
+  if ( a->lsb )
+    a->bits |= code << a->nb ;
+  else
+    a->bits = a->nb ? a->bits << nb | code : code ;
+  a->nb += nb ;
+}
+
+static inline void vide_accumulateur(struct bitstream *b
+				     , struct accumulateur *a)
+{
+  put_bits(b, a->nb, a->bits) ;
+  a->bits = 0 ;
+  a->nb = 0 ;
+}
+
+void put_tableau_entier_signe(struct bitstream *b, const int *v, size_t n)
+{
+  unsigned int u[TAILLE_PAQUET], c, m, signe ;
+  struct accumulateur a = { 0, 0, bitstream_lsb(b) } ;
+  size_t i, j, nb ;
+
+  pthread_once(&tables_calculees, calcule_tables) ;
+  for(i=0; i<n; i+=nb)
+    {
+      nb = MIN(n - i, TAILLE_PAQUET) ;
+      entrelace_signes(u, v + i, nb) ;
+      for(j=0; j<nb; j++)
+	{
+	  m = u[j] >> 1 ;
+	  signe = u[j] & 1 ;
+	  if ( m >= NB_ENTIERS )
+	    EXIT ;
+	  c = codes[a.lsb][m] ;
+	  if ( a.lsb )
+	    accumule(b, &a, LONGUEUR(c) + 1, CODE(c) << 1 | signe) ;
+	  else
+	    accumule(b, &a, LONGUEUR(c) + 1, signe << LONGUEUR(c) | CODE(c)) ;
+	}
+    }
+  vide_accumulateur(b, &a) ;
+}
+
+/*
+ * Plusieurs codes sont décodés dans les FENETRE bits d'un seul
+ * "peek_bits" tant qu'il en reste assez pour le plus long code.
+ * En fin de flot les valeurs après la fin sont fausses,
+ * mais le "skip_bits" final signale l'erreur de lecture.
+ */
+
+void get_tableau_entier_signe(struct bitstream *b, int *v, size_t n)
+{
+  unsigned int u[TAILLE_PAQUET], longueur, pris, f ;
+  unsigned long fenetre, x ;
+  Booleen lsb ;
+  size_t i, j, nb ;
+
+  pthread_once(&tables_calculees, calcule_tables) ;
+  lsb = bitstream_lsb(b) ;
+  for(i=0; i<n; i+=nb)
+    {
+      nb = MIN(n - i, TAILLE_PAQUET) ;
+      fenetre = peek_bits(b, FENETRE) ;
+      pris = 0 ;
+      for(j=0; j<nb; j++)
+	{
+	  if ( pris + LONGUEUR_MAX + 1 > FENETRE )
+	    {
+	      skip_bits(b, pris) ;
+	      fenetre = peek_bits(b, FENETRE) ;
+	      pris = 0 ;
+	    }
+	  if ( lsb )
+	    {
+	      x = fenetre >> pris ;
+	      f = decode(x >> 1 & MASQUE(LONGUEUR_MAX), lsb, &longueur) ;
+	      u[j] = f << 1 | (x & 1) ;
+	    }
+	  else
+	    {
+	      x = fenetre >> (FENETRE - pris - LONGUEUR_MAX - 1) ;
+	      f = decode(x & MASQUE(LONGUEUR_MAX), lsb, &longueur) ;
+	      u[j] = f << 1 | (x >> LONGUEUR_MAX & 1) ;
+	    }
+	  pris += longueur + 1 ;
+	}
+      skip_bits(b, pris) ;
+      desentrelace_signes(v + i, u, nb) ;
+    }
+}
+
+/*
+ * Pour Exp-Golomb les entiers entrelacés sont codés directement.
+ */
+
+void put_tableau_exp_golomb_signe(struct bitstream *b, unsigned int k
+				  , const int *v, size_t n)
+{
+  unsigned int u[TAILLE_PAQUET], q[TAILLE_PAQUET], nb_bits, longueur ;
+  Position_Bit nb_bits_q[TAILLE_PAQUET] ;
+  struct accumulateur a = { 0, 0, bitstream_lsb(b) } ;
+  unsigned long w ;
+  size_t i, j, nb ;
+
+  if ( k >= BITS_LONG )
+    EXIT ;
+  for(i=0; i<n; i+=nb)
+    {
+      nb = MIN(n - i, TAILLE_PAQUET) ;
+      entrelace_signes(u, v + i, nb) ;
+      /*
+       * w = u + 2^k a k bits de plus que (u >> k) + 1 :
+       * les longueurs du paquet sont calculées d'un coup.
+       * Pour k >= 32 c'est toujours k+1 bits, (u >> k) + 1
+       * ne déborde que pour k=0 et u=2^32-1 (33 bits).
+       */
+      if ( k < 32 )
+	{
+	  for(j=0; j<nb; j++)
+	    q[j] = (u[j] >> k) + 1 ;
+	  nb_bits_utile_tableau(q, nb_bits_q, nb) ;
+	}
+      for(j=0; j<nb; j++)
+	{
+	  w = u[j] + TETE(k) ;		/* Pas de retenue : u < 2^32 */
+	  if ( k >= 32 )
+	    nb_bits = k + 1 ;
+	  else
+	    nb_bits = k + (q[j] ? nb_bits_q[j] : 33) ;
+	  longueur = 2 * nb_bits - k - 1 ;
+	  if ( longueur > NB_BITS )
+	    {
+	      vide_accumulateur(b, &a) ;
+	      put_exp_golomb(b, k, u[j]) ;
+	    }
+	  else if ( a.lsb )
+	    accumule(b, &a, longueur, ((w & MASQUE(nb_bits - 1)) << 1 | 1)
+		     << (nb_bits - k - 1)) ;
+	  else
+	    accumule(b, &a, longueur, w) ;
+	}
+    }
+  vide_accumulateur(b, &a) ;
+}
+
+void get_tableau_exp_golomb_signe(struct bitstream *b, unsigned int k
+				  , int *v, size_t n)
+{
+  unsigned int u[TAILLE_PAQUET] ;
+  size_t i, j, nb ;
+
+  for(i=0; i<n; i+=nb)
+    {
+      nb = MIN(n - i, TAILLE_PAQUET) ;
+      for(j=0; j<nb; j++)
+	u[j] = get_exp_golomb(b, k) ;
+      desentrelace_signes(v + i, u, nb) ;
+    }
 }
@@ -13,4 +13,18 @@ unsigned int get_entier(struct bitstream*) ;
 void put_entier_signe(struct bitstream*, int) ;
 int get_entier_signe(struct bitstream*) ;
 
+void put_exp_golomb(struct bitstream*, unsigned int k, unsigned long) ;
+unsigned long get_exp_golomb(struct bitstream*, unsigned int k) ;
+void put_elias_gamma(struct bitstream*, unsigned long) ;
+unsigned long get_elias_gamma(struct bitstream*) ;
+void put_elias_delta(struct bitstream*, unsigned long) ;
+unsigned long get_elias_delta(struct bitstream*) ;
+void put_rice(struct bitstream*, unsigned int k, unsigned long) ;
+unsigned long get_rice(struct bitstream*, unsigned int k) ;
+
+void put_tableau_entier_signe(struct bitstream*, const int*, size_t) ;
+void get_tableau_entier_signe(struct bitstream*, int*, size_t) ;
+void put_tableau_exp_golomb_signe(struct bitstream*, unsigned int k, const int*, size_t) ;
+void get_tableau_exp_golomb_signe(struct bitstream*, unsigned int k, int*, size_t) ;
+
 #endif
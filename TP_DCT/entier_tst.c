@@ -1,5 +1,8 @@
+#include <pthread.h>
 #include "entier.h"
 #include "bases.h"
+#include "exception.h"
+#include "vecteur.h"
 
 static struct
 {
@@ -82,6 +85,23 @@ void get_entier_tst()
 	  }
     }
   close_bitstream(bs) ;
+
+  /* Tous les entiers codables, signés ou non */
+  bs = open_bitstream("xxx", "w") ;
+  for(i=0; i<32768; i++)
+    {
+      put_entier(bs, i) ;
+      put_entier_signe(bs, -i-1) ;
+    }
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", "r") ;
+  for(i=0; i<32768; i++)
+    if ( get_entier(bs) != i || get_entier_signe(bs) != -i-1 )
+      {
+	eprintf("Mauvaise relecture de %d ou de %d\n", i, -i-1) ;
+	return ;
+      }
+  close_bitstream(bs) ;
 }
 
 void put_entier_signe_tst()
@@ -169,3 +189,436 @@ void get_entier_signe_tst()
     }
   close_bitstream(bs) ;
 }
+
+/*
+ * Codes universels
+ */
+
+static struct
+{
+  unsigned int k ;		/* Ordre, ou 100 pour delta */
+  unsigned long entier ;
+  char *chaine ;
+} u[] =
+{
+  {0  , 0    , "1"                },
+  {0  , 1    , "010"              },
+  {0  , 2    , "011"              },
+  {0  , 3    , "00100"            },
+  {0  , 6    , "00111"            },
+  {0  , 7    , "0001000"          },
+  {2  , 0    , "100"              },
+  {2  , 3    , "111"              },
+  {2  , 4    , "01000"            },
+  {2  , 11   , "01111"            },
+  {2  , 12   , "0010000"          },
+  {100, 0    , "1"                },
+  {100, 1    , "0100"             },
+  {100, 2    , "0101"             },
+  {100, 3    , "01100"            },
+  {100, 7    , "00100000"         },
+} ;
+
+static void ecrit_universel(struct bitstream *bs, unsigned int k
+			    , unsigned long v)
+{
+  if ( k == 100 )
+    put_elias_delta(bs, v) ;
+  else if ( k == 0 )
+    put_elias_gamma(bs, v) ;
+  else
+    put_exp_golomb(bs, k, v) ;
+}
+
+static unsigned long lit_universel(struct bitstream *bs, unsigned int k)
+{
+  if ( k == 100 )
+    return get_elias_delta(bs) ;
+  if ( k == 0 )
+    return get_elias_gamma(bs) ;
+  return get_exp_golomb(bs, k) ;
+}
+
+static void verifie_universel(const char *mode)
+{
+  static const unsigned int ordres[] = { 0, 1, 2, 5, 31, 32, 63, 100 } ;
+  unsigned long valeurs[2000] ;
+  struct bitstream *bs ;
+  char lecture[3] ;
+  int i, j, n ;
+
+  for(n=0; n<64; n++)
+    {
+      valeurs[3*n] = 1ul << n ;
+      valeurs[3*n+1] = (1ul << n) - 1 ;
+      valeurs[3*n+2] = ~0ul >> n ;
+    }
+  for(n=3*64; n<TAILLE(valeurs); n++)
+    valeurs[n] = (unsigned long)n * 0x9E3779B97F4A7C15ul >> (n % 64) ;
+
+  bs = open_bitstream("xxx", mode) ;
+  for(i=0; i<TAILLE(ordres); i++)
+    for(j=0; j<TAILLE(valeurs); j++)
+      ecrit_universel(bs, ordres[i], valeurs[j]) ;
+  close_bitstream(bs) ;
+
+  strcpy(lecture, mode) ;
+  lecture[0] = 'r' ;
+  bs = open_bitstream("xxx", lecture) ;
+  for(i=0; i<TAILLE(ordres); i++)
+    for(j=0; j<TAILLE(valeurs); j++)
+      if ( lit_universel(bs, ordres[i]) != valeurs[j] )
+	{
+	  eprintf("Mode \"%s\", ordre %u : mauvaise relecture de %lu\n"
+		  , mode, ordres[i], valeurs[j]) ;
+	  return ;
+	}
+  n = 0 ;
+  EXCEPTION(lit_universel(bs, 0) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    n = 1 ;
+	    break ;
+	    ) ;
+  if ( n == 0 )
+    eprintf("Mode \"%s\" : pas d'exception en lisant après la fin\n", mode);
+  close_bitstream(bs) ;
+}
+
+static void verifie_chaines(unsigned int premier, unsigned int dernier)
+{
+  struct bitstream *bs ;
+  int i, j ;
+
+  bs = open_bitstream("xxx", "w") ;
+  for(i=0; i<TAILLE(u); i++)
+    if ( u[i].k >= premier && u[i].k <= dernier )
+      ecrit_universel(bs, u[i].k, u[i].entier) ;
+  close_bitstream(bs) ;
+
+  bs = open_bitstream("xxx", "r") ;
+  for(i=0; i<TAILLE(u); i++)
+    if ( u[i].k >= premier && u[i].k <= dernier )
+      for(j=0; u[i].chaine[j]; j++)
+	if ( get_bit(bs) != u[i].chaine[j] - '0' )
+	  {
+	    eprintf("Ecriture de l'entier %lu ordre %u (%s en binaire)\n",
+		    u[i].entier, u[i].k, u[i].chaine) ;
+	    eprintf("Mauvaise écriture du bit numero %d (a partir de 0)\n",
+		    j) ;
+	    return ;
+	  }
+  close_bitstream(bs) ;
+}
+
+void put_exp_golomb_tst()
+{
+  verifie_chaines(0, 99) ;
+}
+
+void get_exp_golomb_tst()
+{
+  verifie_universel("w") ;
+  verifie_universel("wl") ;
+}
+
+void put_elias_gamma_tst()
+{
+  verifie_chaines(0, 0) ;
+}
+
+void get_elias_gamma_tst()
+{
+  struct bitstream *bs ;
+
+  bs = open_bitstream("xxx", "w") ;
+  put_elias_gamma(bs, ~0ul) ;
+  put_elias_gamma(bs, 0) ;
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", "r") ;
+  if ( get_elias_gamma(bs) != ~0ul || get_elias_gamma(bs) != 0 )
+    eprintf("Mauvaise relecture de 2^64-1 ou de 0\n") ;
+  close_bitstream(bs) ;
+}
+
+void put_elias_delta_tst()
+{
+  verifie_chaines(100, 100) ;
+}
+
+void get_elias_delta_tst()
+{
+  struct bitstream *bs ;
+
+  bs = open_bitstream("xxx", "w") ;
+  put_elias_delta(bs, ~0ul) ;
+  put_elias_delta(bs, 1ul << 63) ;
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", "r") ;
+  if ( get_elias_delta(bs) != ~0ul || get_elias_delta(bs) != 1ul << 63 )
+    eprintf("Mauvaise relecture de 2^64-1 ou de 2^63\n") ;
+  close_bitstream(bs) ;
+}
+
+void put_rice_tst()
+{
+  static const struct { unsigned int k ; unsigned long v ; char *chaine ; }
+  r[] =
+    {
+      {0, 0 , "1"      },
+      {0, 1 , "01"     },
+      {0, 2 , "001"    },
+      {2, 0 , "100"    },
+      {2, 3 , "111"    },
+      {2, 4 , "0100"   },
+      {2, 9 , "00101"  },
+      /* 32 zéros, Elias gamma de 0 */
+      {0, 32, "000000000000000000000000000000001"},
+    } ;
+  struct bitstream *bs ;
+  int i, j ;
+
+  bs = open_bitstream("xxx", "w") ;
+  for(i=0; i<TAILLE(r); i++)
+    put_rice(bs, r[i].k, r[i].v) ;
+  close_bitstream(bs) ;
+
+  bs = open_bitstream("xxx", "r") ;
+  for(i=0; i<TAILLE(r); i++)
+    for(j=0; r[i].chaine[j]; j++)
+      if ( get_bit(bs) != r[i].chaine[j] - '0' )
+	{
+	  eprintf("Ecriture de l'entier %lu, k=%u (%s en binaire)\n",
+		  r[i].v, r[i].k, r[i].chaine) ;
+	  eprintf("Mauvaise écriture du bit numero %d (a partir de 0)\n", j) ;
+	  return ;
+	}
+  close_bitstream(bs) ;
+}
+
+/*
+ * Sans récupération "EXCEPTION" (d'où le fil d'exécution à part),
+ * un code coupé par la fin du flot doit donner 0 et l'erreur,
+ * y compris pour les grands quotients (Elias gamma) et un flot vide.
+ */
+
+static void *lit_rice_coupe(void *arg)
+{
+  static const char *modes[] = { "w", "wl" } ;
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  unsigned long debut, fin ;
+  size_t taille ;
+  int *resultat = arg ;
+  int m, i ;
+
+  for(m=0; m<TAILLE(modes); m++)
+    {
+      bs = open_bitstream_memory(NULL, 0, modes[m]) ;
+      for(i=0; i<3; i++)
+	put_rice(bs, 3, 1000 + i) ;
+      debut = bitstream_tell_bits(bs) ;
+      put_rice(bs, 3, 100000) ;
+      fin = bitstream_tell_bits(bs) ;
+      zone = close_bitstream_memory(bs, NULL) ;
+
+      taille = (debut + fin) / 16 ;	/* Au milieu du dernier code */
+      bs = open_bitstream_memory(zone, taille, m ? "rl" : "r") ;
+      for(i=0; i<3; i++)
+	if ( get_rice(bs, 3) != 1000ul + i || bitstream_erreur(bs) )
+	  resultat[m] = 1 ;
+      if ( get_rice(bs, 3) != 0
+	   || bitstream_erreur(bs) != Exception_fichier_lecture )
+	resultat[m] = 2 ;
+      close_bitstream(bs) ;
+
+      bs = open_bitstream_memory(zone, m ? 4 : 0, m ? "rl" : "r") ;
+      if ( get_rice(bs, 3) != 0
+	   || bitstream_erreur(bs) != Exception_fichier_lecture )
+	resultat[m] = 3 ;
+      close_bitstream(bs) ;
+      free(zone) ;
+    }
+  return NULL ;
+}
+
+void get_rice_tst()
+{
+  static const char *modes[] = { "w", "wl" } ;
+  static const unsigned int ordres[] = { 0, 1, 3, 7, 20, 40, 63 } ;
+  unsigned long v ;
+  struct bitstream *bs ;
+  char lecture[3] ;
+  int m, i, n ;
+  int resultat[2] = { 0, 0 } ;
+  pthread_t fil ;
+
+  pthread_create(&fil, NULL, lit_rice_coupe, resultat) ;
+  pthread_join(fil, NULL) ;
+  for(m=0; m<TAILLE(modes); m++)
+    if ( resultat[m] )
+      {
+	eprintf("Mode \"%s\" : %s\n", modes[m]
+		, resultat[m] == 1 ? "mauvaise relecture avant la coupure"
+		: resultat[m] == 2 ? "un code coupé doit donner 0 et l'erreur"
+		: "un flot vide doit donner 0 et l'erreur") ;
+	return ;
+      }
+
+  for(m=0; m<TAILLE(modes); m++)
+    {
+      bs = open_bitstream("xxx", modes[m]) ;
+      for(i=0; i<TAILLE(ordres); i++)
+	for(n=0; n<500; n++)
+	  {
+	    v = n < 200 ? n : (unsigned long)n * 0x9E3779B97F4A7C15ul >> (n%64);
+	    put_rice(bs, ordres[i], v) ;
+	  }
+      close_bitstream(bs) ;
+      strcpy(lecture, modes[m]) ;
+      lecture[0] = 'r' ;
+      bs = open_bitstream("xxx", lecture) ;
+      for(i=0; i<TAILLE(ordres); i++)
+	for(n=0; n<500; n++)
+	  {
+	    v = n < 200 ? n : (unsigned long)n * 0x9E3779B97F4A7C15ul >> (n%64);
+	    if ( get_rice(bs, ordres[i]) != v )
+	      {
+		eprintf("Mode \"%s\", k=%u : mauvaise relecture de %lu\n"
+			, modes[m], ordres[i], v) ;
+		return ;
+	      }
+	  }
+      close_bitstream(bs) ;
+    }
+}
+
+/*
+ * Les tableaux doivent donner le même flot que les entiers un par un.
+ * "k" est l'ordre Exp-Golomb ou 100 pour les codes statiques.
+ */
+
+static unsigned int entrelace(int v)
+{
+  return (unsigned int)v << 1 ^ (unsigned int)(v >> 31) ;
+}
+
+static void verifie_tableau(const char *mode, unsigned int k)
+{
+  static int v[3000], w[3000] ;
+  struct bitstream *bs ;
+  char lecture[3] ;
+  int i ;
+
+  for(i=0; i<TAILLE(v); i++)
+    v[i] = i % 7 ? 300 - (i * 7919) % 601 : 32767 - (i * 7919) % 65536 ;
+  if ( k != 100 )
+    {
+      v[0] = -2147483647 - 1 ;
+      v[1] = 2147483647 ;
+    }
+  strcpy(lecture, mode) ;
+  lecture[0] = 'r' ;
+
+  /* Ecriture en tableau (en deux morceaux), relecture un par un */
+  bs = open_bitstream("xxx", mode) ;
+  if ( k == 100 )
+    {
+      put_tableau_entier_signe(bs, v, 1000) ;
+      put_tableau_entier_signe(bs, v + 1000, TAILLE(v) - 1000) ;
+    }
+  else
+    {
+      put_tableau_exp_golomb_signe(bs, k, v, 1000) ;
+      put_tableau_exp_golomb_signe(bs, k, v + 1000, TAILLE(v) - 1000) ;
+    }
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", lecture) ;
+  for(i=0; i<TAILLE(v); i++)
+    if ( k == 100 ? get_entier_signe(bs) != v[i]
+	 : get_exp_golomb(bs, k) != entrelace(v[i]) )
+      {
+	eprintf("Mode \"%s\" ordre %u : %d mal écrit\n", mode, k, v[i]) ;
+	return ;
+      }
+  close_bitstream(bs) ;
+
+  /* Ecriture un par un, relecture en tableau */
+  bs = open_bitstream("xxx", mode) ;
+  for(i=0; i<TAILLE(v); i++)
+    if ( k == 100 )
+      put_entier_signe(bs, v[i]) ;
+    else
+      put_exp_golomb(bs, k, entrelace(v[i])) ;
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", lecture) ;
+  if ( k == 100 )
+    get_tableau_entier_signe(bs, w, TAILLE(w)) ;
+  else
+    get_tableau_exp_golomb_signe(bs, k, w, TAILLE(w)) ;
+  close_bitstream(bs) ;
+  for(i=0; i<TAILLE(v); i++)
+    if ( v[i] != w[i] )
+      {
+	eprintf("Mode \"%s\" ordre %u : %d est relu %d\n", mode, k, v[i], w[i]);
+	return ;
+      }
+}
+
+void put_tableau_entier_signe_tst()
+{
+  static const char *versions[] = { "base", "sse2", "avx2" } ;
+  int k ;
+
+  for(k=0; k<TAILLE(versions); k++)
+    {
+      if ( vecteur_force(versions[k]) == 0 )
+	continue ;
+      verifie_tableau("w", 100) ;
+      verifie_tableau("wl", 100) ;
+      verifie_tableau("w", 0) ;
+    }
+  vecteur_force(NULL) ;
+}
+
+void get_tableau_entier_signe_tst()
+{
+  int v[1], t ;
+  struct bitstream *bs ;
+
+  put_tableau_entier_signe_tst() ;
+
+  /* Lire après la fin du flot lance l'exception */
+  bs = open_bitstream("xxx", "w") ;
+  put_entier_signe(bs, 5) ;
+  close_bitstream(bs) ;
+  bs = open_bitstream("xxx", "r") ;
+  get_tableau_entier_signe(bs, v, 1) ;
+  if ( v[0] != 5 )
+    eprintf("Mauvaise relecture de 5\n") ;
+  t = 0 ;
+  EXCEPTION(get_tableau_entier_signe(bs, v, 1) ;
+	    ,
+	    ,
+	    case Exception_fichier_lecture:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    eprintf("Pas d'exception en lisant après la fin\n") ;
+  close_bitstream(bs) ;
+}
+
+void put_tableau_exp_golomb_signe_tst()
+{
+  verifie_tableau("w", 0) ;
+  verifie_tableau("wl", 0) ;
+  verifie_tableau("w", 3) ;
+  verifie_tableau("wl", 40) ;
+}
+
+void get_tableau_exp_golomb_signe_tst()
+{
+  put_tableau_exp_golomb_signe_tst() ;
+}
@@ -9,19 +9,27 @@
 #include <setjmp.h>
 #include <stdlib.h>
 
-extern volatile struct exception_c
+/*
+ * Chaque fil d'exécution (thread) a sa propre pile de récupérations :
+ * une exception ne remonte que dans le fil qui l'a lancée.
+ * La pile a une profondeur fixe, il n'y a pas d'allocation.
+ */
+
+#define EXCEPTION_PROFONDEUR_MAX 16
+
+extern __thread struct exception_c
 {
-  int profondeur ;
-  int profondeur_max ;
-  jmp_buf *buf ;
-  int valeur_de_retour ;
+  volatile int profondeur ;
+  jmp_buf      buf[EXCEPTION_PROFONDEUR_MAX] ;
+  volatile int valeur_de_retour ;
+  volatile int derniere ;	/* Dernière exception signalée */
 } global_exception ;
 
 /*
  * Le programme principal doit déclarer le système d'exception
  */
 
-#define EXCEPTION_DECLARATION volatile struct exception_c global_exception = { 0 }
+#define EXCEPTION_DECLARATION __thread struct exception_c global_exception = { 0 }
 
 /*
  * Lancer une exception pour indiquer un problème
@@ -31,7 +39,40 @@ extern volatile struct exception_c
  * La liste des exceptions est à la fin de ce fichier
  */
 
-#define EXCEPTION_LANCE(VAL) longjmp(global_exception.buf[global_exception.profondeur-1], VAL)
+#define EXCEPTION_LANCE(VAL)						     \
+do {									     \
+     global_exception.derniere = (VAL) ;				     \
+     if ( global_exception.profondeur == 0 )				     \
+       {								     \
+	 fprintf(stderr, "***** Exception non récupérée : %d\n"	     \
+		 , global_exception.derniere) ;				     \
+	 abort() ;							     \
+       }								     \
+     longjmp(global_exception.buf[global_exception.profondeur-1]	     \
+	     , global_exception.derniere) ;				     \
+   } while(0)
+
+/*
+ * Signaler un problème sur un contexte (un "bitstream" par exemple)
+ * qui garde le numéro de l'exception dans son champ ERREUR.
+ *    - Si une récupération "EXCEPTION" est en cours dans ce fil
+ *      d'exécution, c'est un EXCEPTION_LANCE.
+ *    - Sinon la fonction qui signale retourne "..." (rien pour
+ *      une fonction "void") et l'appelant consulte le contexte.
+ * Il n'y a ainsi ni "setjmp" ni pile à gérer pour détecter une fin
+ * de fichier dans une boucle de décodage.
+ *
+ * Sans contexte, ERREUR peut être "global_exception.derniere".
+ */
+
+#define EXCEPTION_SIGNALE(ERREUR, VAL, ...)				     \
+do {									     \
+     (ERREUR) = (VAL) ;							     \
+     global_exception.derniere = (VAL) ;				     \
+     if ( global_exception.profondeur )					     \
+       longjmp(global_exception.buf[global_exception.profondeur-1], VAL) ; \
+     return __VA_ARGS__ ;						     \
+   } while(0)
 
 /*
  * Exécuter un morceau de programme en récupérant les exceptions
@@ -48,10 +89,11 @@ extern volatile struct exception_c
  * les différents cas, quand l'exception a eu lieu.
  */
 #define EXCEPTION(CORPS, MENAGE, CAS)					     \
-if ( global_exception.profondeur >= global_exception.profondeur_max )	     \
-     global_exception.buf = realloc(global_exception.buf		     \
-				    , ++global_exception.profondeur_max	     \
-				      *sizeof(*global_exception.buf));	     \
+if ( global_exception.profondeur >= EXCEPTION_PROFONDEUR_MAX )		     \
+    {									     \
+      fprintf(stderr, "***** Trop de EXCEPTION imbriqués\n") ;		     \
+      abort() ;								     \
+    }									     \
 global_exception.valeur_de_retour =					     \
 	   setjmp(global_exception.buf[global_exception.profondeur]) ;	     \
 if ( global_exception.valeur_de_retour == 0 )				     \
@@ -88,6 +130,10 @@ enum {
   Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture,
   Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture,
   Exception_arbre_shannon_fano_invalide,
+  Exception_marqueur_segment_invalide,
+  Exception_fichier_positionnement,
+  Exception_ordre_bits_invalide,
+  Exception_somme_controle_invalide,
 
   Exception_derniere
 } ;
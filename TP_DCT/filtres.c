@@ -11,6 +11,7 @@
 #include "bitstream.h"
 #include "exception.h"
 #include "ondelette.h"
+#include "sortie.h"
 
 #define LARG 8 /* 8 blocs à afficher */
 
@@ -25,14 +26,58 @@ struct parametres
   float qualite ;
   int shannon ;
   int saute_entete ;
+  int asynchrone ;	/* Nombre de tampons écrits en tâche de fond */
+  int reprise ;		/* Nombre de blocs par segment (0 : pas de segment) */
+  int segment ;		/* Premier segment décodé */
+  int crc ;		/* Segments vérifiés par un CRC32C */
+  int lsb ;		/* Flot de bits poids faible en premier */
+  int periode ;		/* Codes shannon-fano refaits tous les N symboles */
+  long seuil ;		/* Occurrences shannon-fano divisées au-delà */
+  int evenements_max ;	/* Valeurs shannon-fano distinctes (0 : illimité) */
+  FILE *statistiques ;	/* Décompte JSON des flots (NULL : aucun) */
 } ;
 
+/*
+ * Les lectures et écritures ne sont pas dans des "assert"
+ * qui disparaissent quand on compile avec -DNDEBUG.
+ */
+
 void fread_safe(void *ptr, size_t size, size_t nr, FILE *f)
 {
-  assert(fread(ptr, size, nr, f) == nr) ;
+  if ( fread(ptr, size, nr, f) != nr )
+    {
+      if ( ferror(f) )
+	perror("fread") ;
+      EXIT ;
+    }
 }
 
-#define fwrite(A,B,C,D) assert(fwrite(A,B,C,D) == (C))
+static void sortie_ecrit_safe(const void *octets, size_t nb)
+{
+  if ( sortie_ecrit(octets, nb) )
+    {
+      perror("sortie_ecrit") ;
+      EXIT ;
+    }
+}
+
+/*
+ * A appeler à la fin des filtres qui écrivent par "sortie_ecrit" :
+ * le dernier tampon n'est envoyé que là.
+ */
+
+static void sortie_vide_safe(void)
+{
+  if ( sortie_vide() )
+    {
+      perror("sortie_vide") ;
+      EXIT ;
+    }
+}
+
+#define fwrite(A,B,C,D) do { if ( fwrite(A,B,C,D) != (C) )	\
+                               { perror("fwrite") ; EXIT ; }	\
+                           } while(0)
 
 void affiche_son(struct parametres *p)
 {
@@ -130,9 +175,9 @@ void filtre_dct(struct parametres *p)
       for(i=0;i<p->nbe;i++)
 	entree[i] = buf[i] - 128. ;
       dct(0, p->nbe, entree, sortie) ;
-      assert(write(1, (char*)sortie, p->nbe*sizeof(*sortie))
-	     == p->nbe*sizeof(*sortie)) ;
+      sortie_ecrit_safe(sortie, p->nbe*sizeof(*sortie)) ;
     } 
+  sortie_vide_safe() ;
   free(buf) ;
   free(entree) ;
   free(sortie) ;
@@ -145,8 +190,212 @@ void saute_entete(struct parametres *p)
   if ( p->saute_entete )
     {
        fread_safe((char*)buf, 1, sizeof(buf), stdin ) ;
-      fwrite((char*)buf, 1, sizeof(buf), stdout) ;
+      sortie_ecrit_safe(buf, sizeof(buf)) ;
+    }
+}
+
+/*
+ * Le flot de bits écrit sur la sortie standard.
+ * Si ASYNCHRONE=n, il est écrit en tâche de fond avec "n" tampons.
+ * Si LSB=1, les bits sont rangés poids faible en premier
+ * (le décodeur doit aussi avoir LSB=1).
+ */
+
+static struct bitstream *open_bitstream_sortie(struct parametres *p)
+{
+  if ( p->asynchrone )
+    return open_bitstream_asynchrone("-", p->lsb ? "wl" : "w", p->asynchrone);
+  return open_bitstream("-", p->lsb ? "wl" : "w") ;
+}
+
+/*
+ * Sans récupération "EXCEPTION" en cours, une erreur d'écriture
+ * (même dans le fil asynchrone) n'est connue qu'à la fermeture.
+ */
+
+static void close_bitstream_safe(struct bitstream *bs)
+{
+  int erreur ;
+
+  erreur = close_bitstream(bs) ;
+  if ( erreur )
+    {
+      fprintf(stderr, "***** Exception non récupérée : %d\n", erreur) ;
+      EXIT ;
+    }
+}
+
+/*
+ * Les flots d'entiers de "rle" et "rleinv" suivant SHANNON :
+ *    0 : codes statiques (entiers jusqu'à 32767)
+ *    1 : shannon-fano dynamique (retourné, NULL sinon)
+ *    2 : codes Exp-Golomb d'ordre 0 (entiers de 64 bits)
+ *    3 : codes de Rice adaptatifs (rapide, proche de shannon-fano)
+ * Avec PERIODE=N les codes shannon-fano ne sont refaits que tous
+ * les N symboles (voir "shannon_fano_periode").
+ * Avec SEUIL=N les occurrences sont divisées par 2 quand leur total
+ * dépasse N (voir "shannon_fano_seuil").
+ * Avec EVENEMENTS_MAX=N la table ne garde que N valeurs distinctes,
+ * les suivantes sont codées après ESCAPE
+ * (voir "shannon_fano_nb_evenements_max").
+ * Ces réglages valent aussi pour "sf8" et "sf16".
+ */
+
+static struct shannon_fano *open_shannon_fano_parametre(struct parametres *p)
+{
+  struct shannon_fano *sf ;
+
+  sf = open_shannon_fano() ;
+  if ( p->periode )
+    shannon_fano_periode(sf, p->periode) ;
+  shannon_fano_seuil(sf, p->seuil) ;
+  if ( p->evenements_max )
+    shannon_fano_nb_evenements_max(sf, p->evenements_max) ;
+  return sf ;
+}
+
+static struct shannon_fano *open_intstreams(struct parametres *p
+					    , struct bitstream *bs
+					    , struct intstream **entier
+					    , struct intstream **entier_signe)
+{
+  struct shannon_fano *sf ;
+
+  switch(p->shannon)
+    {
+    case 0:
+      *entier = open_intstream(bs, Entier, NULL) ;
+      *entier_signe = open_intstream(bs, Entier_Signe, NULL) ;
+      return NULL ;
+    case 2:
+      *entier = open_intstream(bs, Exp_Golomb, NULL) ;
+      *entier_signe = open_intstream(bs, Exp_Golomb_Signe, NULL) ;
+      return NULL ;
+    case 3:
+      *entier = open_intstream(bs, Rice_Adaptatif, NULL) ;
+      *entier_signe = open_intstream(bs, Rice_Adaptatif_Signe, NULL) ;
+      return NULL ;
+    default:
+      sf = open_shannon_fano_parametre(p) ;
+      *entier = open_intstream(bs, Shannon_fano, sf) ;
+      *entier_signe = open_intstream(bs, Shannon_fano, sf) ;
+      return sf ;
+    }
+}
+
+/*
+ * Avec STATISTIQUES=fichier, chaque flot ajoute une ligne JSON
+ * à ce fichier en se fermant (STATISTIQUES=- : erreur standard).
+ */
+
+static void statistiques_flots(struct parametres *p, struct bitstream *bs
+			       , struct intstream *entier
+			       , struct intstream *entier_signe)
+{
+  if ( p->statistiques == NULL )
+    return ;
+  bitstream_statistiques(bs, p->statistiques, p->nom) ;
+  if ( entier )
+    intstream_statistiques(entier, p->statistiques, "longueurs_plages") ;
+  if ( entier_signe )
+    intstream_statistiques(entier_signe, p->statistiques, "valeurs") ;
+}
+
+/*
+ * Avec REPRISE=N le flot est découpé en segments de N blocs
+ * (voir "put_debut_segment" dans "rle.c").
+ * La table de shannon-fano (et l'état des codes de Rice)
+ * repart de zéro à chaque segment
+ * pour que les segments soient décodables indépendamment.
+ * Avec CRC=1 chaque segment se termine par un CRC32C,
+ * le décodeur le trouve dans l'en-tête du segment.
+ * Avec SEGMENT=K le décodeur va directement au segment K grâce
+ * à l'index de fin de flot (voir "va_au_segment") et ne décode que
+ * les suivants : l'entrée doit être un fichier ("<"), pas un tube.
+ */
+
+static void compresse_segments(struct parametres *p, struct bitstream *bs
+			       , struct intstream *entier
+			       , struct intstream *entier_signe
+			       , struct shannon_fano *sf)
+{
+  float *entree ;
+  unsigned long *positions ;
+  int nb_segments, nb_blocs, i ;
+
+  ALLOUER(entree, p->nbe * p->reprise) ;
+  ALLOUER(positions, 1) ;
+  nb_segments = 0 ;
+  for(;;)
+    {
+      nb_blocs = fread((char*)entree, p->nbe*sizeof(*entree), p->reprise
+		       , stdin) ;
+      positions = realloc(positions, (nb_segments+1) * sizeof(*positions)) ;
+      if ( positions == NULL )
+	EXIT ;
+      if ( p->crc && nb_blocs )
+	positions[nb_segments] = put_debut_segment_crc(bs, nb_segments
+						       , nb_blocs) ;
+      else
+	positions[nb_segments] = put_debut_segment(bs, nb_segments, nb_blocs);
+      if ( nb_blocs == 0 )
+	break ;
+      if ( sf )
+	reinitialise_shannon_fano(sf) ;
+      reinitialise_intstream(entier) ;
+      reinitialise_intstream(entier_signe) ;
+      for(i=0; i<nb_blocs; i++)
+	compresse(entier, entier_signe, p->nbe, entree + i*p->nbe) ;
+      put_fin_segment(bs) ;
+      nb_segments++ ;
     }
+  put_index_segments(bs, nb_segments, positions) ;
+  free(positions) ;
+  free(entree) ;
+}
+
+static void decompresse_segments(struct parametres *p, struct bitstream *bs
+				 , struct intstream *entier
+				 , struct intstream *entier_signe
+				 , struct shannon_fano *sf)
+{
+  float *entree ;
+  int numero, nb_blocs, i ;
+
+  if ( p->segment && va_au_segment(bs, p->segment) )
+    {
+      fprintf(stderr, "Segment %d introuvable (flot sans index"
+	      " ou qui n'est pas un fichier)\n", p->segment) ;
+      EXIT ;
+    }
+  ALLOUER(entree, p->nbe) ;
+  for(numero=p->segment; (nb_blocs = get_debut_segment(bs, numero)) != 0
+	; numero++)
+    {
+      if ( sf )
+	reinitialise_shannon_fano(sf) ;
+      reinitialise_intstream(entier) ;
+      reinitialise_intstream(entier_signe) ;
+      for(i=0; i<nb_blocs; i++)
+	{
+	  decompresse(entier, entier_signe, p->nbe, entree) ;
+	  if ( bitstream_erreur(bs) )
+	    break ;
+	  sortie_ecrit_safe(entree, p->nbe*sizeof(*entree)) ;
+	}
+      if ( bitstream_erreur(bs) )
+	break ;
+      get_fin_segment(bs) ;
+      if ( bitstream_erreur(bs) )
+	break ;
+    }
+  if ( bitstream_erreur(bs) )
+    {
+      fprintf(stderr, "***** Exception non récupérée : %d\n"
+	      , bitstream_erreur(bs)) ;
+      EXIT ;
+    }
+  free(entree) ;
 }
 
 void filtre_rle(struct parametres *p)
@@ -160,17 +409,17 @@ void filtre_rle(struct parametres *p)
     p->nbe *= p->nbe ;
 
   saute_entete(p) ;
-  bs = open_bitstream("-", "w") ;
-  if ( p->shannon )
-    {
-      sf = open_shannon_fano() ;
-      entier = open_intstream(bs, Shannon_fano, sf) ;
-      entier_signe = open_intstream(bs, Shannon_fano, sf) ;
-    }
-  else
+  bs = open_bitstream_sortie(p) ;
+  sf = open_intstreams(p, bs, &entier, &entier_signe) ;
+  statistiques_flots(p, bs, entier, entier_signe) ;
+
+  if ( p->reprise )
     {
-      entier = open_intstream(bs, Entier, NULL) ;
-      entier_signe = open_intstream(bs, Entier_Signe, NULL) ;
+      compresse_segments(p, bs, entier, entier_signe, sf) ;
+      close_intstream(entier) ;
+      close_intstream(entier_signe) ;
+      close_bitstream_safe(bs) ;
+      return ;
     }
 
   ALLOUER(entree, p->nbe) ;
@@ -182,7 +431,7 @@ void filtre_rle(struct parametres *p)
   free(entree) ;
   close_intstream(entier) ;
   close_intstream(entier_signe) ;
-  close_bitstream(bs) ;
+  close_bitstream_safe(bs) ;
 }
 
 void filtre_rleinv(struct parametres *p)
@@ -196,39 +445,44 @@ void filtre_rleinv(struct parametres *p)
     p->nbe *= p->nbe ;
 
   saute_entete(p) ;
-  bs = open_bitstream("-", "r") ;
-  if ( p->shannon )
-    {
-      sf = open_shannon_fano() ;
-      entier = open_intstream(bs, Shannon_fano, sf) ;
-      entier_signe = open_intstream(bs, Shannon_fano, sf) ;
-    }
-  else
+  bs = open_bitstream_mmap("-", p->lsb ? "rl" : "r") ;
+  sf = open_intstreams(p, bs, &entier, &entier_signe) ;
+  statistiques_flots(p, bs, entier, entier_signe) ;
+
+  if ( p->reprise )
     {
-      entier = open_intstream(bs, Entier, NULL) ;
-      entier_signe = open_intstream(bs, Entier_Signe, NULL) ;
+      decompresse_segments(p, bs, entier, entier_signe, sf) ;
+      sortie_vide_safe() ;
+      close_intstream(entier) ;
+      close_intstream(entier_signe) ;
+      close_bitstream_safe(bs) ;
+      return ;
     }
  
   ALLOUER(entree, p->nbe) ;
-  EXCEPTION(
-  {
-    for(;;)
-      {
-	decompresse(entier, entier_signe, p->nbe, entree) ;
-	fwrite(entree, p->nbe, sizeof(*entree), stdout) ;
-      }
-  }
-    ,
-	,
-	case Exception_fichier_lecture:
-	  break ;
-
-  ) ;
+  /*
+   * Pas de récupération "EXCEPTION" en cours :
+   * la fin du flot est signalée sur "bs" (voir "bitstream_erreur").
+   */
+  for(;;)
+    {
+      decompresse(entier, entier_signe, p->nbe, entree) ;
+      if ( bitstream_erreur(bs) )
+	break ;
+      sortie_ecrit_safe(entree, p->nbe*sizeof(*entree)) ;
+    }
+  if ( bitstream_erreur(bs) != Exception_fichier_lecture )
+    {
+      fprintf(stderr, "***** Exception non récupérée : %d\n"
+	      , bitstream_erreur(bs)) ;
+      EXIT ;
+    }
+  sortie_vide_safe() ;
 
   free(entree) ;
   close_intstream(entier) ;
   close_intstream(entier_signe) ;
-  close_bitstream(bs) ;
+  close_bitstream_safe(bs) ;
 }
 
 void filtre_psycho(struct parametres *p)
@@ -239,9 +493,9 @@ void filtre_psycho(struct parametres *p)
   while( fread((char*)buf,1,p->nbe*sizeof(*buf),stdin) == p->nbe*sizeof(*buf) )
     {
       psycho(p->nbe, buf, p->qualite) ;
-      assert(write(1, (char*)buf, p->nbe*sizeof(*buf))
-	     == p->nbe*sizeof(*buf));
+      sortie_ecrit_safe(buf, p->nbe*sizeof(*buf)) ;
     } 
+  sortie_vide_safe() ;
   free(buf) ;
 }
 
@@ -261,8 +515,9 @@ void filtre_shannon_fano_8(struct parametres *p)
   struct bitstream *bs ;
   int c ;
 
-  sf = open_shannon_fano() ;
-  bs = open_bitstream("-", "w") ;
+  sf = open_shannon_fano_parametre(p) ;
+  bs = open_bitstream_sortie(p) ;
+  statistiques_flots(p, bs, NULL, NULL) ;
 
   for(;;)
     {
@@ -271,7 +526,7 @@ void filtre_shannon_fano_8(struct parametres *p)
 	break ;
       put_entier_shannon_fano(bs, sf, c) ;
     }
-  close_bitstream(bs) ;
+  close_bitstream_safe(bs) ;
   close_shannon_fano(sf) ;  
 }
 
@@ -281,8 +536,9 @@ void filtre_shannon_fano_16(struct parametres *p)
   struct bitstream *bs ;
   int c, d ;
 
-  sf = open_shannon_fano() ;
-  bs = open_bitstream("-", "w") ;
+  sf = open_shannon_fano_parametre(p) ;
+  bs = open_bitstream_sortie(p) ;
+  statistiques_flots(p, bs, NULL, NULL) ;
 
   for(;;)
     {
@@ -294,7 +550,7 @@ void filtre_shannon_fano_16(struct parametres *p)
 	break ;
       put_entier_shannon_fano(bs, sf, c*256+d) ;
     }
-  close_bitstream(bs) ;
+  close_bitstream_safe(bs) ;
   close_shannon_fano(sf) ;  
 }
 
@@ -324,8 +580,9 @@ void filtre_dctinv(struct parametres *p)
       dct(1, p->nbe, entree, sortie) ;
       for(i=0;i<p->nbe;i++)
 	buf[i] = sortie[i] + 128. ;
-      assert(write(1, (char*)buf, p->nbe) == p->nbe) ;
+      sortie_ecrit_safe(buf, p->nbe) ;
     } 
+  sortie_vide_safe() ;
   free(buf) ;
   free(entree) ;
   free(sortie) ;
@@ -339,8 +596,8 @@ void filtre_quantif(struct parametres *p)
 
   fread_safe(&hauteur, 1, sizeof(hauteur), stdin) ;
   fread_safe(&largeur, 1, sizeof(largeur), stdin) ;
-  fwrite(&hauteur, 1, sizeof(hauteur), stdout) ;
-  fwrite(&largeur, 1, sizeof(largeur), stdout) ;
+  sortie_ecrit_safe(&hauteur, sizeof(hauteur)) ;
+  sortie_ecrit_safe(&largeur, sizeof(largeur)) ;
   bloc = allocation_matrice_float(p->nbe, p->nbe) ;
 
   nb_blocs = ((hauteur+p->nbe-1)/p->nbe) * ((largeur+p->nbe-1)/p->nbe) ;
@@ -353,8 +610,9 @@ void filtre_quantif(struct parametres *p)
       quantification(p->nbe, p->qualite, bloc, p->lit_flottant) ;
 
       for(i=0; i<p->nbe; i++)
-	fwrite((char*)bloc->t[i],p->nbe,sizeof(bloc->t[0][0]),stdout) ;
+	sortie_ecrit_safe(bloc->t[i], p->nbe*sizeof(bloc->t[0][0])) ;
     }
+  sortie_vide_safe() ;
 }
 
 void filtre_zigzag(struct parametres *p)
@@ -365,8 +623,8 @@ void filtre_zigzag(struct parametres *p)
 
   fread_safe(&hauteur, 1, sizeof(hauteur), stdin) ;
   fread_safe(&largeur, 1, sizeof(largeur), stdin) ;
-  fwrite(&hauteur, 1, sizeof(hauteur), stdout) ;
-  fwrite(&largeur, 1, sizeof(largeur), stdout) ;
+  sortie_ecrit_safe(&hauteur, sizeof(hauteur)) ;
+  sortie_ecrit_safe(&largeur, sizeof(largeur)) ;
   bloc = allocation_matrice_float(p->nbe, p->nbe) ;
 
   nb_blocs = ((hauteur+p->nbe-1)/p->nbe) * ((largeur+p->nbe-1)/p->nbe) ;
@@ -380,12 +638,13 @@ void filtre_zigzag(struct parametres *p)
       y = 0 ;
       for(;;)
 	{
-	  fwrite((char*)&bloc->t[y][x], 1, sizeof(bloc->t[0][0]), stdout) ;
+	  sortie_ecrit_safe(&bloc->t[y][x], sizeof(bloc->t[0][0])) ;
 	  if ( x==p->nbe-1 && y==p->nbe-1 )
 	    break ;
 	  zigzag(p->nbe, &y, &x) ;
 	}
     }
+  sortie_vide_safe() ;
 }
 
 void filtre_zigzaginv(struct parametres *p)
@@ -396,8 +655,8 @@ void filtre_zigzaginv(struct parametres *p)
 
   fread_safe(&hauteur, 1, sizeof(hauteur), stdin) ;
   fread_safe(&largeur, 1, sizeof(largeur), stdin) ;
-  fwrite(&hauteur, 1, sizeof(hauteur), stdout) ;
-  fwrite(&largeur, 1, sizeof(largeur), stdout) ;
+  sortie_ecrit_safe(&hauteur, sizeof(hauteur)) ;
+  sortie_ecrit_safe(&largeur, sizeof(largeur)) ;
   bloc = allocation_matrice_float(p->nbe, p->nbe) ;
 
   nb_blocs = ((hauteur+p->nbe-1)/p->nbe) * ((largeur+p->nbe-1)/p->nbe) ;
@@ -415,13 +674,14 @@ void filtre_zigzaginv(struct parametres *p)
 	}
 
       for(i=0; i<p->nbe; i++)
-	fwrite((char*)bloc->t[i],p->nbe,sizeof(bloc->t[0][0]),stdout) ;
+	sortie_ecrit_safe(bloc->t[i], p->nbe*sizeof(bloc->t[0][0])) ;
     }
+  sortie_vide_safe() ;
 }
 
 void filtre_ondelette(struct parametres *p)
 {
-   ondelette_encode_image(p->qualite) ;
+   ondelette_encode_image(p->qualite, p->asynchrone) ;
 }
 
 void filtre_ondeletteinv(struct parametres *p)
@@ -486,6 +746,43 @@ void filtres(int argc, char **argv)
 	if ( getenv("SAUTE_ENTETE") )
 	  pp.saute_entete = atof(getenv("SAUTE_ENTETE")) ;
 
+	if ( getenv("ASYNCHRONE") )
+	  pp.asynchrone = atoi(getenv("ASYNCHRONE")) ;
+
+	if ( getenv("REPRISE") )
+	  pp.reprise = atoi(getenv("REPRISE")) ;
+
+	if ( getenv("SEGMENT") )
+	  pp.segment = atoi(getenv("SEGMENT")) ;
+
+	if ( getenv("LSB") )
+	  pp.lsb = atoi(getenv("LSB")) ;
+
+	if ( getenv("CRC") )
+	  pp.crc = atoi(getenv("CRC")) ;
+
+	if ( getenv("PERIODE") )
+	  pp.periode = atoi(getenv("PERIODE")) ;
+
+	if ( getenv("SEUIL") )
+	  pp.seuil = atol(getenv("SEUIL")) ;
+
+	if ( getenv("EVENEMENTS_MAX") )
+	  pp.evenements_max = atoi(getenv("EVENEMENTS_MAX")) ;
+
+	if ( getenv("STATISTIQUES") )
+	  {
+	    if ( strcmp(getenv("STATISTIQUES"), "-") == 0 )
+	      pp.statistiques = stderr ;
+	    else
+	      pp.statistiques = fopen(getenv("STATISTIQUES"), "a") ;
+	    if ( pp.statistiques == NULL )
+	      {
+		perror(getenv("STATISTIQUES")) ;
+		exit(1) ;
+	      }
+	  }
+
 	(*p[i].fct)(&pp) ;
 	exit(0) ;
       }
@@ -1,3 +1,6 @@
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "image.h"
 
 
@@ -56,24 +59,112 @@ void liberation_image(struct image* image)
 }
 
 /*
- * Allocation et lecture d'un image au format PGM.
- * (L'entête commence par "P5\nLargeur Hauteur\n255\n"
- * Avec des lignes de commentaire possibles avant la dernière.
+ * Lecture d'un entier positif de l'entête PGM en mémoire,
+ * après avoir sauté les blancs et les commentaires.
+ * Retourne -1 si ce n'est pas un entier.
  */
 
-struct image* lecture_image(FILE *f)
+static int lit_entier_entete(const unsigned char *zone, size_t taille
+			     , size_t *position)
 {
+  int v ;
+
+  while( *position < taille
+	 && (isspace(zone[*position]) || zone[*position] == '#') )
+    if ( zone[(*position)++] == '#' )
+      while( *position < taille && zone[*position] != '\n' )
+	(*position)++ ;
+  if ( *position == taille || !isdigit(zone[*position]) )
+    return -1 ;
+  v = 0 ;
+  while( *position < taille && isdigit(zone[*position]) )
+    v = 10*v + zone[(*position)++] - '0' ;
+  return v ;
+}
 
-  int largeur,hauteur;
-  fscanf(f,"P5\n%d %d\n255\n",&largeur,&hauteur);
-  struct image * img = allocation_image(hauteur,largeur);
+/*
+ * Allocation et lecture d'une image au format PGM qui est déjà
+ * en mémoire (les "taille" octets de "zone").
+ * On stocke dans "*utilise" (s'il n'est pas NULL) le nombre
+ * d'octets de "zone" occupés par l'image.
+ * Les pixels manquants (fichier tronqué) sont mis à 0.
+ */
 
-    for(int i=0; i<img->hauteur;i++)
-    for(int j=0; j<img->largeur; j++)
-      img->pixels[i][j] = fgetc(f);
+struct image* lecture_image_memoire(const unsigned char *zone, size_t taille
+				    , size_t *utilise)
+{
+  struct image *img ;
+  size_t position, n ;
+  int largeur, hauteur, i ;
+
+  if ( taille < 2 || zone[0] != 'P' || zone[1] != '5' )
+    EXIT ;
+  position = 2 ;
+  largeur = lit_entier_entete(zone, taille, &position) ;
+  hauteur = lit_entier_entete(zone, taille, &position) ;
+  if ( largeur < 0 || hauteur < 0
+       || lit_entier_entete(zone, taille, &position) != 255 )
+    EXIT ;
+  position++ ;			/* Un seul blanc avant les pixels */
+
+  img = allocation_image(hauteur, largeur) ;
+  for(i=0; i<hauteur; i++)
+    {
+      n = position < taille ? MIN(taille - position, (size_t)largeur) : 0 ;
+      memcpy(img->pixels[i], zone + position, n) ;
+      memset(img->pixels[i] + n, 0, largeur - n) ;
+      position += largeur ;
+    }
+  if ( utilise )
+    *utilise = MIN(position, taille) ;
+  return img ;
+}
 
+/*
+ * Allocation et lecture d'un image au format PGM.
+ * (L'entête commence par "P5\nLargeur Hauteur\n255\n"
+ * Avec des lignes de commentaire possibles avant la dernière.
+ *
+ * Si "f" est un fichier normal, on le projette en mémoire ("mmap")
+ * et on le lit avec "lecture_image_memoire" : pas de copie par stdio
+ * ni de verrouillage à chaque octet.
+ * La position dans "f" est ensuite placée juste après l'image.
+ * Sinon (tube, terminal...) on le lit ligne de pixels par ligne.
+ */
 
-  return img ; /* pour enlever un warning du compilateur */
+struct image* lecture_image(FILE *f)
+{
+  struct image *img ;
+  struct stat st ;
+  unsigned char *zone ;
+  size_t utilise ;
+  long debut ;
+  int largeur, hauteur, i ;
+
+  if ( fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)
+       && (debut = ftell(f)) >= 0 && st.st_size > debut )
+    {
+      zone = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0) ;
+      if ( zone != MAP_FAILED )
+	{
+	  img = lecture_image_memoire(zone + debut, st.st_size - debut
+				      , &utilise) ;
+	  munmap(zone, st.st_size) ;
+	  fseek(f, debut + utilise, SEEK_SET) ;
+	  return img ;
+	}
+    }
+
+  if ( fscanf(f, "P5 %d %d 255", &largeur, &hauteur) != 2 )
+    EXIT ;
+  getc(f) ;			/* Un seul blanc avant les pixels */
+  img = allocation_image(hauteur, largeur) ;
+  for(i=0; i<hauteur; i++)
+    {
+      utilise = fread(img->pixels[i], 1, largeur, f) ;
+      memset(img->pixels[i] + utilise, 0, largeur - utilise) ;
+    }
+  return img ;
 }
 
 /*
@@ -20,6 +20,7 @@ void lire_ligne(FILE *f, char *ligne) ;
 struct image* allocation_image(int hauteur, int largeur) ;
 void liberation_image(struct image*) ;
 struct image* lecture_image(FILE *f) ;
+struct image* lecture_image_memoire(const unsigned char *zone, size_t taille, size_t *utilise) ;
 void ecriture_image(FILE *f, const struct image *image) ;
 
 #endif
@@ -97,6 +97,39 @@ void lecture_image_tst()
 }
 
 
+void lecture_image_memoire_tst()
+{
+  struct image *image, *image2 ;
+  unsigned char zone[40000] ;
+  size_t taille, utilise ;
+  FILE *f ;
+  int j ;
+
+  f = fopen("DONNEES/bat710.pgm","r") ;
+  taille = fread(zone, 1, sizeof(zone), f) ;
+  fclose(f) ;
+
+  image = lecture_image_memoire(zone, taille, &utilise) ;
+  if ( utilise != taille )
+    {
+      eprintf("L'image occupe %lu octets et non %lu\n"
+	      , (unsigned long)taille, (unsigned long)utilise) ;
+      return ;
+    }
+  image2 = lecture_image(fopen("DONNEES/bat710.pgm","r")) ;
+  if ( image->hauteur != image2->hauteur || image->largeur != image2->largeur )
+    {
+      eprintf("lecture_image_memoire : mauvaises dimensions\n") ;
+      return ;
+    }
+  for(j=0; j<image->hauteur; j++)
+    if ( memcmp(image->pixels[j], image2->pixels[j], image->largeur) )
+      {
+	eprintf("lecture_image_memoire : ligne %d différente\n", j) ;
+	return ;
+      }
+}
+
 void ecriture_image_tst()
 {
   struct image *image ;
@@ -2,11 +2,32 @@
 #include "sf.h"
 #include "entier.h"
 
+/*
+ * Statistiques (voir "intstream_statistiques").
+ * Les longueurs de code de plus de NB_LONGUEURS-1 bits
+ * sont comptées dans la dernière case.
+ */
+#define NB_LONGUEURS 65
+
+struct statistiques
+{
+  FILE *json ;				  /* Où écrire à la fermeture */
+  const char *nom ;
+  unsigned long nb_symboles ;
+  unsigned long nb_bits ;
+  unsigned long nb_escapes ;
+  unsigned long longueurs[NB_LONGUEURS] ; /* Nb de symboles par longueur */
+} ;
+
 struct intstream
 {
   enum intstream_type type ;
   struct bitstream *bitstream ;           /* Dans tous les cas, le bitstream */
   struct shannon_fano *shannon_fano ;     /* Si type==Shanno_fano */
+  struct statistiques *statistiques ;     /* NULL si pas de statistiques */
+  unsigned int parametre ;                /* Ordre si type==Exp_Golomb */
+  unsigned long somme ;                   /* Rice : somme des valeurs */
+  unsigned int nb ;                       /* Rice : et leur nombre */
 } ;
 
 
@@ -19,6 +40,10 @@ struct intstream* open_intstream(struct bitstream *bitstream
   ALLOUER(is, 1) ;
   is->bitstream = bitstream ;
   is->type = type ;
+  is->shannon_fano = NULL ;
+  is->statistiques = NULL ;
+  is->parametre = 0 ;
+  reinitialise_intstream(is) ;
 
   if ( type == Shannon_fano )
     {
@@ -30,12 +55,134 @@ struct intstream* open_intstream(struct bitstream *bitstream
   return(is) ;
 }
 
+/*
+ * Codes de Rice adaptatifs (comme dans LOCO-I) : le paramètre "k"
+ * est le plus petit tel que nb * 2^k >= somme, où "somme" et "nb"
+ * portent sur les valeurs déjà codées. Les deux sont divisés par 2
+ * quand "nb" atteint RICE_MEMOIRE pour suivre les variations.
+ * Le codeur et le décodeur font la même mise à jour après chaque valeur.
+ */
+
+#define RICE_MEMOIRE 64
+
+void reinitialise_intstream(struct intstream *is)
+{
+  is->somme = 1 ;
+  is->nb = 1 ;
+}
+
+static inline unsigned int parametre_rice(const struct intstream *is)
+{
+  return nb_bits_utile((is->somme - 1) / is->nb) ;
+}
+
+static inline unsigned long apprend_rice(struct intstream *is
+					 , unsigned long v)
+{
+  is->somme = is->somme + v < v ? ~0ul : is->somme + v ;
+  if ( ++is->nb == RICE_MEMOIRE )
+    {
+      is->somme = (is->somme + 1) / 2 ;
+      is->nb /= 2 ;
+    }
+  return v ;
+}
+
+void intstream_parametre(struct intstream *is, unsigned int k)
+{
+  if ( k >= 8 * sizeof(unsigned long) )
+    EXIT ;
+  is->parametre = k ;
+}
+
+/*
+ * Active le comptage des symboles (écrits ou lus), de leurs bits,
+ * des ESCAPE du shannon-fano et de l'histogramme des longueurs de code.
+ * Le décompte est écrit dans "json" par "close_intstream"
+ * sous la forme d'un objet JSON sur une ligne.
+ *
+ * Les longueurs sont mesurées avec "bitstream_tell_bits" autour de
+ * chaque symbole : un flot sans statistiques ne paye qu'un test.
+ */
+
+void intstream_statistiques(struct intstream *is, FILE *json, const char *nom)
+{
+  if ( is->statistiques == NULL )
+    ALLOUER(is->statistiques, 1) ;
+  memset(is->statistiques, 0, sizeof(*is->statistiques)) ;
+  is->statistiques->json = json ;
+  is->statistiques->nom = nom ;
+}
+
+static void ecrit_statistiques(const struct intstream *is)
+{
+  static const char *types[] = { "entier", "entier_signe", "shannon_fano"
+				 , "elias_gamma", "elias_delta", "exp_golomb"
+				 , "exp_golomb_signe", "rice_adaptatif"
+				 , "rice_adaptatif_signe" } ;
+  const struct statistiques *s = is->statistiques ;
+  int i, max ;
+
+  for(max=NB_LONGUEURS; max>0 && s->longueurs[max-1] == 0; max--)
+    ;
+  fprintf(s->json, "{\"intstream\": \"%s\", \"codage\": \"%s\""
+	  ", \"symboles\": %lu, \"bits\": %lu, \"escapes\": %lu"
+	  ", \"longueurs\": ["
+	  , s->nom, types[is->type], s->nb_symboles, s->nb_bits, s->nb_escapes);
+  for(i=0; i<max; i++)
+    fprintf(s->json, i ? ", %lu" : "%lu", s->longueurs[i]) ;
+  fprintf(s->json, "]}\n") ;
+  fflush(s->json) ;
+}
+
 void close_intstream(struct intstream *is)
 {
+  if ( is->statistiques )
+    {
+      ecrit_statistiques(is) ;
+      free(is->statistiques) ;
+    }
   free(is) ;
 }
 
-void put_entier_intstream(struct intstream *is, int evenement)
+/*
+ * Etat avant le codage d'un symbole, puis comptage après.
+ */
+
+static unsigned long nb_escapes(const struct intstream *is)
+{
+  return is->shannon_fano ? nb_escapes_shannon_fano(is->shannon_fano) : 0 ;
+}
+
+static void compte_symbole(struct intstream *is, unsigned long debut
+			   , unsigned long escapes)
+{
+  struct statistiques *s = is->statistiques ;
+  unsigned long longueur ;
+
+  longueur = bitstream_tell_bits(is->bitstream) - debut ;
+  s->nb_symboles++ ;
+  s->nb_bits += longueur ;
+  s->nb_escapes += nb_escapes(is) - escapes ;
+  s->longueurs[MIN(longueur, NB_LONGUEURS-1)]++ ;
+}
+
+/*
+ * Les entiers signés de "Exp_Golomb_Signe" sont entrelacés
+ * pour devenir positifs : 0 1 -1 2 -2 ... --> 0 2 1 4 3 ...
+ */
+
+static inline unsigned long entrelace(unsigned long v)
+{
+  return v << 1 ^ -(v >> 63) ;
+}
+
+static inline unsigned long desentrelace(unsigned long v)
+{
+  return v >> 1 ^ -(v & 1) ;
+}
+
+static inline void ecrit_entier(struct intstream *is, unsigned long evenement)
 {
   switch(is->type)
     {
@@ -48,12 +195,60 @@ void put_entier_intstream(struct intstream *is, int evenement)
     case Entier_Signe:
       put_entier_signe(is->bitstream, evenement) ;
       break ;
+    case Elias_Gamma:
+      put_elias_gamma(is->bitstream, evenement) ;
+      break ;
+    case Elias_Delta:
+      put_elias_delta(is->bitstream, evenement) ;
+      break ;
+    case Exp_Golomb:
+      put_exp_golomb(is->bitstream, is->parametre, evenement) ;
+      break ;
+    case Exp_Golomb_Signe:
+      put_exp_golomb(is->bitstream, is->parametre, entrelace(evenement)) ;
+      break ;
+    case Rice_Adaptatif_Signe:
+      evenement = entrelace(evenement) ;
+      /* Pas de break */
+    case Rice_Adaptatif:
+      put_rice(is->bitstream, parametre_rice(is), evenement) ;
+      apprend_rice(is, evenement) ;
+      break ;
     default:
       EXIT ;
     }
 }
 
-int get_entier_intstream(struct intstream *is)
+void put_entier_long_intstream(struct intstream *is, unsigned long evenement)
+{
+  unsigned long debut, escapes ;
+
+  if ( is->statistiques == NULL )
+    {
+      ecrit_entier(is, evenement) ;
+      return ;
+    }
+  debut = bitstream_tell_bits(is->bitstream) ;
+  escapes = nb_escapes(is) ;
+  ecrit_entier(is, evenement) ;
+  compte_symbole(is, debut, escapes) ;
+}
+
+/*
+ * Un "int" est étendu avec son signe sauf pour les codes
+ * universels positifs.
+ */
+
+void put_entier_intstream(struct intstream *is, int evenement)
+{
+  if ( is->type == Elias_Gamma || is->type == Elias_Delta
+       || is->type == Exp_Golomb || is->type == Rice_Adaptatif )
+    put_entier_long_intstream(is, (unsigned int)evenement) ;
+  else
+    put_entier_long_intstream(is, (long)evenement) ;
+}
+
+static inline unsigned long lit_entier(struct intstream *is)
 {
   switch(is->type)
     {
@@ -63,7 +258,83 @@ int get_entier_intstream(struct intstream *is)
       return( get_entier(is->bitstream) ) ;
     case Entier_Signe:
       return( get_entier_signe(is->bitstream) ) ;
+    case Elias_Gamma:
+      return( get_elias_gamma(is->bitstream) ) ;
+    case Elias_Delta:
+      return( get_elias_delta(is->bitstream) ) ;
+    case Exp_Golomb:
+      return( get_exp_golomb(is->bitstream, is->parametre) ) ;
+    case Exp_Golomb_Signe:
+      return( desentrelace(get_exp_golomb(is->bitstream, is->parametre)) ) ;
+    case Rice_Adaptatif:
+      return( apprend_rice(is, get_rice(is->bitstream, parametre_rice(is))) ) ;
+    case Rice_Adaptatif_Signe:
+      return( desentrelace(apprend_rice(is, get_rice(is->bitstream
+						      , parametre_rice(is)))));
     default:
       EXIT ;
     }
 }
+
+unsigned long get_entier_long_intstream(struct intstream *is)
+{
+  unsigned long debut, escapes, v ;
+
+  if ( is->statistiques == NULL )
+    return lit_entier(is) ;
+  debut = bitstream_tell_bits(is->bitstream) ;
+  escapes = nb_escapes(is) ;
+  v = lit_entier(is) ;
+  compte_symbole(is, debut, escapes) ;
+  return v ;
+}
+
+int get_entier_intstream(struct intstream *is)
+{
+  return get_entier_long_intstream(is) ;
+}
+
+int intstream_erreur(const struct intstream *is)
+{
+  return bitstream_erreur(is->bitstream) ;
+}
+
+void put_entiers_signes(struct intstream *is, const int *v, size_t n)
+{
+  size_t i ;
+
+  if ( is->statistiques == NULL )
+    switch(is->type)
+      {
+      case Entier_Signe:
+	put_tableau_entier_signe(is->bitstream, v, n) ;
+	return ;
+      case Exp_Golomb_Signe:
+	put_tableau_exp_golomb_signe(is->bitstream, is->parametre, v, n) ;
+	return ;
+      default:
+	break ;
+      }
+  for(i=0; i<n; i++)
+    put_entier_intstream(is, v[i]) ;
+}
+
+void get_entiers_signes(struct intstream *is, int *v, size_t n)
+{
+  size_t i ;
+
+  if ( is->statistiques == NULL )
+    switch(is->type)
+      {
+      case Entier_Signe:
+	get_tableau_entier_signe(is->bitstream, v, n) ;
+	return ;
+      case Exp_Golomb_Signe:
+	get_tableau_exp_golomb_signe(is->bitstream, is->parametre, v, n) ;
+	return ;
+      default:
+	break ;
+      }
+  for(i=0; i<n; i++)
+    v[i] = get_entier_intstream(is) ;
+}
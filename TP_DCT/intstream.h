@@ -5,6 +5,9 @@
 #ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_INTSTREAM_H
 #define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_INTSTREAM_H
 
+#include <stdio.h>
+#include <stddef.h>
+
 struct bitstream ;
 struct shannon_fano ;
 struct intstream ;
@@ -20,6 +23,12 @@ enum intstream_type
 {  Entier
   ,Entier_Signe
   ,Shannon_fano
+  ,Elias_Gamma			/* Codes universels (voir "entier.c") */
+  ,Elias_Delta
+  ,Exp_Golomb			/* Ordre donné par "intstream_parametre" */
+  ,Exp_Golomb_Signe
+  ,Rice_Adaptatif		/* Paramètre suivant la moyenne des valeurs */
+  ,Rice_Adaptatif_Signe
 } ;
 
 /*
@@ -35,5 +44,39 @@ struct intstream* open_intstream(struct bitstream *bitstream
 void        close_intstream(struct intstream *is) ;
 void   put_entier_intstream(struct intstream *is, int evenement) ;
 int    get_entier_intstream(struct intstream *is) ;
+/*
+ * Ecriture/lecture de "n" entiers signés d'un coup, même flot
+ * que "n" appels à "put_entier_intstream".
+ * C'est plus rapide pour "Entier_Signe" et "Exp_Golomb_Signe"
+ * (sans statistiques), les autres types font une boucle.
+ */
+void put_entiers_signes(struct intstream *is, const int *v, size_t n) ;
+void get_entiers_signes(struct intstream *is, int *v, size_t n) ;
+/*
+ * Entiers de 64 bits : les codes universels codent tous les
+ * entiers de 0 à 2^64-1 (de -2^63 à 2^63-1 pour "Exp_Golomb_Signe").
+ * Pour les autres types la valeur doit tenir dans un "int".
+ */
+void   put_entier_long_intstream(struct intstream *is, unsigned long evenement) ;
+unsigned long get_entier_long_intstream(struct intstream *is) ;
+/*
+ * Ordre "k" (de 0 à 63) des codes "Exp_Golomb", 0 par défaut.
+ */
+void intstream_parametre(struct intstream *is, unsigned int k) ;
+/*
+ * Remet l'état adaptatif (codes de Rice) à celui de l'ouverture,
+ * par exemple au début d'un segment décodable indépendamment.
+ */
+void reinitialise_intstream(struct intstream *is) ;
+/*
+ * Exception signalée sur le bitstream (voir "bitstream_erreur"),
+ * par exemple la fin du flot pendant une lecture.
+ */
+int intstream_erreur(const struct intstream *is) ;
+/*
+ * Comptage optionnel des symboles et de leurs bits,
+ * écrit en JSON dans "json" à la fermeture.
+ */
+void intstream_statistiques(struct intstream *is, FILE *json, const char *nom) ;
 
 #endif
@@ -212,7 +212,11 @@ void compresse_image(int nbe, const struct image *entree, FILE *f)
 	extrait_matrice(j, i, nbe, entree, tmp) ;
 	dct_image(0, nbe, tmp) ;
 	for(k=0; k<nbe; k++)
-	  assert(fwrite(tmp->t[k], sizeof(tmp->t[0][0]), nbe, f) == nbe) ;
+	  if ( fwrite(tmp->t[k], sizeof(tmp->t[0][0]), nbe, f) != nbe )
+	    {
+	      perror("compresse_image") ;
+	      EXIT ;
+	    }
       }
  }
 
@@ -235,7 +239,8 @@ void decompresse_image(int nbe, struct image *entree, FILE *f)
     for(i=0;i<entree->largeur;i+=nbe)
       {
 	for(k=0; k<nbe; k++)
-	  assert(fread(tmp->t[k], sizeof(tmp->t[0][0]), nbe, f) == nbe) ;
+	  if ( fread(tmp->t[k], sizeof(tmp->t[0][0]), nbe, f) != nbe )
+	    EXIT ;
 	dct_image(1, nbe, tmp) ;
 	insert_matrice(j, i, nbe, tmp, entree) ;
       }
@@ -149,14 +149,15 @@ void quantif_ondelette(Matrice *image, float qualite)
  * d'être bien compressé par la RLE.
  * Cette fonction n'est pas optimale, elle devrait faire
  * un parcours de Péano sur chacun des blocs.
+ *
+ * Le "bitstream" (fichier ou mémoire) n'est pas fermé.
  */
 
-void codage_ondelette(Matrice *image, FILE *f)
+void codage_ondelette(Matrice *image, struct bitstream *bs)
  {
   int j, i ;
   float *t, *pt ;
   struct intstream *entier, *entier_signe ;
-  struct bitstream *bs ;
   struct shannon_fano *sf ;
   int hau, lar ;
 
@@ -183,7 +184,6 @@ void codage_ondelette(Matrice *image, FILE *f)
   /*
    * Compression RLE avec Shannon-Fano
    */
-  bs = open_bitstream("-", "w") ;
   sf = open_shannon_fano() ;
   entier = open_intstream(bs, Shannon_fano, sf) ;
   entier_signe = open_intstream(bs, Shannon_fano, sf) ;
@@ -192,7 +192,7 @@ void codage_ondelette(Matrice *image, FILE *f)
 
   close_intstream(entier) ;
   close_intstream(entier_signe) ;
-  close_bitstream(bs) ;
+  close_shannon_fano(sf) ;
   free(t) ;
  }
 
@@ -294,12 +294,11 @@ void dequantif_ondelette(Matrice *image, float qualite)
       image->t[i][j] = image->t[i][j]*(1+(i+j+1)*qualite/100);
 }
 
-void decodage_ondelette(Matrice *image, FILE *f)
+void decodage_ondelette(Matrice *image, struct bitstream *bs)
  {
   int j, i ;
   float *t, *pt ;
   struct intstream *entier, *entier_signe ;
-  struct bitstream *bs ;
   struct shannon_fano *sf ;
   int largeur = image->width, hauteur = image->height ;
 
@@ -307,7 +306,6 @@ void decodage_ondelette(Matrice *image, FILE *f)
    * Decompression RLE avec Shannon-Fano
    */
   ALLOUER(t, hauteur*largeur) ;
-  bs = open_bitstream("-", "r") ;
   sf = open_shannon_fano() ;
   entier = open_intstream(bs, Shannon_fano, sf) ;
   entier_signe = open_intstream(bs, Shannon_fano, sf) ;
@@ -316,7 +314,7 @@ void decodage_ondelette(Matrice *image, FILE *f)
 
   close_intstream(entier) ;
   close_intstream(entier_signe) ;
-  close_bitstream(bs) ;
+  close_shannon_fano(sf) ;
 
   /*
    * Met dans la matrice
@@ -344,23 +342,29 @@ void decodage_ondelette(Matrice *image, FILE *f)
 
 export QUALITE=1  # Qualité de "quantification"
 export SHANNON=1  # Si 1, utilise shannon-fano dynamique
+export ASYNCHRONE=2  # Si non nul, écriture en tâche de fond
 ondelette <DONNEES/bat710.pgm 1 >xxx && ls -ls xxx && ondelette_inv <xxx | xv -
 
  */
 
-void ondelette_encode_image(float qualite)
+void ondelette_encode_image(float qualite, int nb_tampons)
  {
   struct image *image ;
+  struct bitstream *bs ;
   Matrice *im ;
-  int i, j ;
+  int i, j, erreur ;
 
   image = lecture_image(stdin) ;
-  assert(fwrite(&image->hauteur, 1, sizeof(image->hauteur), stdout)
-	 == sizeof(image->hauteur)) ;
-  assert(fwrite(&image->largeur, 1, sizeof(image->largeur), stdout)
-	 == sizeof(image->largeur));
-  assert(fwrite(&qualite       , 1, sizeof(qualite)       , stdout)
-	 == sizeof(qualite));
+  if ( fwrite(&image->hauteur, 1, sizeof(image->hauteur), stdout)
+       != sizeof(image->hauteur)
+       || fwrite(&image->largeur, 1, sizeof(image->largeur), stdout)
+       != sizeof(image->largeur)
+       || fwrite(&qualite       , 1, sizeof(qualite)       , stdout)
+       != sizeof(qualite) )
+    {
+      perror("ondelette_encode_image") ;
+      EXIT ;
+    }
 
   im = allocation_matrice_float(image->hauteur, image->largeur) ;
   for(j=0; j<image->hauteur; j++)
@@ -373,7 +377,17 @@ void ondelette_encode_image(float qualite)
   fprintf(stderr, "Quantification qualité = %g\n", qualite) ;
   quantif_ondelette(im, qualite) ;
   fprintf(stderr, "Codage\n") ;
-  codage_ondelette(im, stdout) ;
+  if ( nb_tampons )
+    bs = open_bitstream_asynchrone("-", "w", nb_tampons) ;
+  else
+    bs = open_bitstream("-", "w") ;
+  codage_ondelette(im, bs) ;
+  erreur = close_bitstream(bs) ;
+  if ( erreur )
+    {
+      fprintf(stderr, "***** Exception non récupérée : %d\n", erreur) ;
+      EXIT ;
+    }
 
   //  affiche_matrice_float(im, image->hauteur, image->largeur) ;
  }
@@ -383,16 +397,20 @@ void ondelette_decode_image()
   int hauteur, largeur ;
   float qualite ;
   struct image *image ;
+  struct bitstream *bs ;
   Matrice *im ;
 
-  assert(fread(&hauteur, 1, sizeof(hauteur), stdin) == sizeof(hauteur)) ;
-  assert(fread(&largeur, 1, sizeof(largeur), stdin) == sizeof(largeur)) ;
-  assert(fread(&qualite, 1, sizeof(qualite), stdin) == sizeof(qualite)) ;
+  if ( fread(&hauteur, 1, sizeof(hauteur), stdin) != sizeof(hauteur)
+       || fread(&largeur, 1, sizeof(largeur), stdin) != sizeof(largeur)
+       || fread(&qualite, 1, sizeof(qualite), stdin) != sizeof(qualite) )
+    EXIT ;
 
   im = allocation_matrice_float(hauteur, largeur) ;
 
   fprintf(stderr, "Décodage\n") ;
-  decodage_ondelette(im, stdin ) ;
+  bs = open_bitstream_mmap("-", "r") ;
+  decodage_ondelette(im, bs) ;
+  close_bitstream(bs) ;
 
   fprintf(stderr, "Déquantification qualité = %g\n", qualite) ;
   dequantif_ondelette(im, qualite) ;
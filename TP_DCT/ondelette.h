@@ -11,7 +11,11 @@ void ondelette_2d(Matrice *image) ;
 void ondelette_1d_inverse(const float *entree, float *sortie, int nbe) ;
 void ondelette_2d_inverse(Matrice *image) ;
 
-void ondelette_encode_image(float qualite) ; /**/
+struct bitstream ;
+
+void codage_ondelette(Matrice *image, struct bitstream *bs) ; /**/
+void decodage_ondelette(Matrice *image, struct bitstream *bs) ; /**/
+void ondelette_encode_image(float qualite, int nb_tampons) ; /**/
 void ondelette_decode_image() ; /**/
 
 
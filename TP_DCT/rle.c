@@ -1,5 +1,8 @@
 #include "bases.h"
 #include "intstream.h"
+#include "bitstream.h"
+#include "bits.h"
+#include "exception.h"
 #include "rle.h"
 
 /*
@@ -89,7 +92,10 @@ void decompresse(struct intstream *entier, struct intstream *entier_signe
 		while(i < nbe)
 		{
 			int nb_zeros = get_entier_intstream(entier);
-			while(nb_zeros != 0)
+			/* Fin du flot (sans EXCEPTION en cours) */
+			if ( intstream_erreur(entier) )
+				return;
+			while(nb_zeros != 0 && i < nbe)
 			{
 				dct[i] = 0;
 				nb_zeros--;
@@ -106,3 +112,233 @@ void decompresse(struct intstream *entier, struct intstream *entier_signe
 		}
 
 }
+
+/*
+ * Marqueurs de reprise
+ *
+ * Pour pouvoir décoder un flot sans partir du premier octet
+ * (reprise après une erreur, décodage en parallèle)
+ * on le découpe en segments de quelques blocs.
+ * Chaque segment commence sur une frontière d'octet par :
+ *     - MARQUEUR_SEGMENT avec le numéro du segment dans l'octet de droite
+ *     - Le nombre de blocs du segment
+ * Le dernier segment est vide (0 bloc) et il est suivi de l'index :
+ *     - La position en octets de chacun des segments (64 bits)
+ *     - Le nombre de segments (32 bits)
+ *     - La position en octets du début de l'index (64 bits)
+ *     - MARQUEUR_INDEX (32 bits)
+ * Les positions de 64 bits sont écrites en deux fois 32 bits,
+ * poids fort en premier : un flot peut dépasser 4 Go.
+ * Comme l'index est à la fin, on le trouve à partir de la taille du flot
+ * et "va_au_segment" permet de commencer le décodage à n'importe
+ * quel segment.
+ *
+ * Un segment peut être vérifié par un CRC32C ("put_debut_segment_crc") :
+ * le bit AVEC_CRC est mis dans son nombre de blocs et le segment se
+ * termine, sur une frontière d'octet, par le CRC32C de ses données
+ * (tout ce qui suit l'en-tête). Le lecteur le voit dans l'en-tête,
+ * il n'a rien à savoir à l'avance.
+ *
+ * C'est à l'appelant de remettre l'état des codeurs à zéro
+ * au début de chaque segment ("reinitialise_shannon_fano").
+ */
+
+#define MARQUEUR_SEGMENT 0x52535400	/* "RST" + numéro */
+#define MARQUEUR_INDEX   0x52535449	/* "RSTI" */
+#define TAILLE_PIED_INDEX 16		/* nb_segments, début, marqueur */
+#define AVEC_CRC         0x80000000	/* Dans le nombre de blocs */
+
+/*
+ * Ecrit le début d'un segment et retourne sa position en octets.
+ */
+
+unsigned long put_debut_segment(struct bitstream *bs, int numero
+				, int nb_blocs)
+{
+  unsigned long position ;
+
+  bitstream_align(bs) ;
+  position = bitstream_tell_bits(bs) / 8 ;
+  put_bits(bs, 32, MARQUEUR_SEGMENT | (numero & 0xFF)) ;
+  put_bits(bs, 32, nb_blocs) ;
+  return position ;
+}
+
+/*
+ * Même chose pour un segment terminé par un CRC32C
+ * qu'on écrit avec "put_fin_segment".
+ */
+
+unsigned long put_debut_segment_crc(struct bitstream *bs, int numero
+				    , int nb_blocs)
+{
+  unsigned long position ;
+
+  position = put_debut_segment(bs, numero, nb_blocs | AVEC_CRC) ;
+  bitstream_crc_debut(bs) ;
+  return position ;
+}
+
+/*
+ * Fin d'un segment : écrit son CRC32C s'il a été commencé
+ * par "put_debut_segment_crc", sinon ne fait rien.
+ */
+
+void put_fin_segment(struct bitstream *bs)
+{
+  unsigned int crc ;
+
+  if ( bitstream_crc_fin(bs, &crc) )
+    put_bits(bs, 32, crc) ;
+}
+
+/*
+ * Lit le début du segment "numero" et retourne son nombre de blocs.
+ * Si le marqueur n'est pas le bon, on signale l'exception
+ *         Exception_marqueur_segment_invalide
+ * (sans récupération en cours, on retourne 0 comme pour le dernier segment)
+ */
+
+int get_debut_segment(struct bitstream *bs, int numero)
+{
+  unsigned int nb_blocs ;
+
+  bitstream_align(bs) ;
+  if ( get_bits(bs, 32) != (MARQUEUR_SEGMENT | (numero & 0xFF)) )
+    {
+      bitstream_signale(bs, Exception_marqueur_segment_invalide) ;
+      return 0 ;
+    }
+  nb_blocs = get_bits(bs, 32) ;
+  if ( nb_blocs & AVEC_CRC )
+    bitstream_crc_debut(bs) ;
+  return nb_blocs & ~AVEC_CRC ;
+}
+
+/*
+ * A appeler après le dernier bloc de chaque segment.
+ * Si le segment a un CRC32C, on le vérifie et s'il est faux
+ * on signale l'exception
+ *         Exception_somme_controle_invalide
+ */
+
+void get_fin_segment(struct bitstream *bs)
+{
+  unsigned int crc ;
+
+  if ( bitstream_crc_fin(bs, &crc) && get_bits(bs, 32) != crc )
+    bitstream_signale(bs, Exception_somme_controle_invalide) ;
+}
+
+static void put_position(struct bitstream *bs, unsigned long position)
+{
+  put_bits(bs, 32, (unsigned long long)position >> 32) ;
+  put_bits(bs, 32, position & 0xFFFFFFFF) ;
+}
+
+static unsigned long get_position(struct bitstream *bs)
+{
+  unsigned long long position ;
+
+  position = (unsigned long long)get_bits(bs, 32) << 32 ;
+  position |= get_bits(bs, 32) ;
+  return position ;
+}
+
+/*
+ * Ecrit l'index qui termine le flot (après le segment vide).
+ */
+
+void put_index_segments(struct bitstream *bs, int nb_segments
+			, const unsigned long *positions)
+{
+  unsigned long debut ;
+  int i ;
+
+  bitstream_align(bs) ;
+  debut = bitstream_tell_bits(bs) / 8 ;
+  for(i=0; i<nb_segments; i++)
+    put_position(bs, positions[i]) ;
+  put_bits(bs, 32, nb_segments) ;
+  put_position(bs, debut) ;
+  put_bits(bs, 32, MARQUEUR_INDEX) ;
+}
+
+/*
+ * Retrouve l'index à la fin des "taille" octets de "zone"
+ * (le flot complet, par exemple projeté en mémoire).
+ * Retourne le nombre de segments et alloue "*positions"
+ * (à libérer par l'appelant).
+ * Retourne -1 si le flot ne se termine pas par un index valide.
+ * Pour un flot LSB, les segments se relisent avec le mode "rL".
+ */
+
+int get_index_segments(const unsigned char *zone, size_t taille
+		       , unsigned long **positions)
+{
+  struct bitstream *bs ;
+  unsigned long debut ;
+  int nb_segments, i ;
+  const char *mode ;
+
+  if ( taille < TAILLE_PIED_INDEX )
+    return -1 ;
+  /*
+   * Un flot LSB commence par "LSB\1", un flot MSB par MARQUEUR_SEGMENT.
+   * On relit l'index dans le même ordre de bits, sans l'en-tête.
+   */
+  mode = taille >= 4 && memcmp(zone, "LSB\1", 4) == 0 ? "rL" : "r" ;
+  bs = open_bitstream_memory((unsigned char*)zone + taille - TAILLE_PIED_INDEX
+			     , TAILLE_PIED_INDEX, mode) ;
+  nb_segments = get_bits(bs, 32) ;
+  debut = get_position(bs) ;
+  i = get_bits(bs, 32) != MARQUEUR_INDEX ;
+  close_bitstream(bs) ;
+  if ( i || nb_segments < 0
+       || debut > taille - TAILLE_PIED_INDEX
+       || (taille - TAILLE_PIED_INDEX - debut) / 8 != (size_t)nb_segments
+       || (taille - TAILLE_PIED_INDEX - debut) % 8 != 0 )
+    return -1 ;
+
+  ALLOUER(*positions, nb_segments + 1) ;
+  bs = open_bitstream_memory((unsigned char*)zone + debut
+			     , 8 * nb_segments, mode) ;
+  for(i=0; i<nb_segments; i++)
+    (*positions)[i] = get_position(bs) ;
+  close_bitstream(bs) ;
+  return nb_segments ;
+}
+
+/*
+ * Positionne la lecture de "bs" au début du segment "numero"
+ * en cherchant sa position dans l'index (avec "bitstream_seek_bits").
+ * Le décodage continue ensuite normalement par
+ * "get_debut_segment(bs, numero)", les segments précédents
+ * ne sont pas lus.
+ * Le flot doit être en mémoire ou projeté ("bitstream_zone").
+ * Retourne -1 (sans déplacer la lecture) si ce n'est pas le cas,
+ * si le flot n'a pas d'index ou si le segment n'existe pas.
+ */
+
+int va_au_segment(struct bitstream *bs, int numero)
+{
+  const unsigned char *zone ;
+  unsigned long *positions ;
+  size_t taille ;
+  int nb_segments ;
+
+  zone = bitstream_zone(bs, &taille) ;
+  if ( zone == NULL )
+    return -1 ;
+  nb_segments = get_index_segments(zone, taille, &positions) ;
+  if ( nb_segments < 0 )
+    return -1 ;
+  if ( numero < 0 || numero >= nb_segments )
+    {
+      free(positions) ;
+      return -1 ;
+    }
+  bitstream_seek_bits(bs, 8 * positions[numero]) ;
+  free(positions) ;
+  return 0 ;
+}
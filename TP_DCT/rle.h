@@ -5,10 +5,22 @@
 #ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_RLE_H
 #define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_RLE_H
 
+#include <stddef.h>
+
 struct intstream ;
+struct bitstream ;
 
 void compresse(struct intstream *entier, struct intstream *entier_signe, int nbe, const float *dct) ;
 void decompresse(struct intstream *entier, struct intstream *entier_signe, int nbe, float *dct) ;
 
+unsigned long put_debut_segment(struct bitstream *bs, int numero, int nb_blocs) ;
+unsigned long put_debut_segment_crc(struct bitstream *bs, int numero, int nb_blocs) ;
+void          put_fin_segment(struct bitstream *bs) ;
+int           get_debut_segment(struct bitstream *bs, int numero) ;
+void          get_fin_segment(struct bitstream *bs) ;
+void         put_index_segments(struct bitstream *bs, int nb_segments, const unsigned long *positions) ;
+int          get_index_segments(const unsigned char *zone, size_t taille, unsigned long **positions) ;
+int                va_au_segment(struct bitstream *bs, int numero) ;
+
 
 #endif
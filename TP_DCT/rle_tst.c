@@ -2,6 +2,10 @@
 #include "rle.h"
 #include "bitstream.h"
 #include "intstream.h"
+#include "bits.h"
+#include "sf.h"
+#include "exception.h"
+#include "crc.h"
 
 void compresse_test(int nb_t, float *t, int nb_ok, int *ok)
 {
@@ -71,6 +75,8 @@ void decompresse_tst()
   struct bitstream *bs ;
 
   float t[TAILLE(ok)+1] ;
+  unsigned char *zone ;
+  size_t taille ;
   int i ;
 
   compresse_tst() ;		/* Pour créer "xxx" */
@@ -95,4 +101,392 @@ void decompresse_tst()
 	eprintf("Vous avez débordé du tableau\n", i) ;
 	return ;
       }
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_bitstream(bs) ;
+
+  /* Une suite de zéros trop longue (flot abîmé) ne déborde pas */
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  entier = open_intstream(bs, Entier, NULL) ;
+  put_entier_intstream(entier, 1000) ;
+  close_intstream(entier) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+  bs = open_bitstream_memory(zone, taille, "r") ;
+  entier = open_intstream(bs, Entier, NULL) ;
+  entier_signe = open_intstream(bs, Entier_Signe, NULL) ;
+  t[TAILLE(ok)] = 1234 ;
+  decompresse(entier, entier_signe, TAILLE(ok), t) ;
+  if ( t[TAILLE(ok)] != 1234 )
+    {
+      eprintf("Une suite de 1000 zéros déborde du tableau\n") ;
+      return ;
+    }
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_bitstream_memory(bs, NULL) ;
+  free(zone) ;
+}
+
+void put_debut_segment_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  static unsigned char ok[] = { 0x80, 0x52, 0x53, 0x54, 0x03
+				, 0x00, 0x00, 0x00, 0x05 } ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  put_bit(bs, 1) ;
+  if ( put_debut_segment(bs, 3, 5) != 1 )
+    {
+      eprintf("Le segment doit commencer sur l'octet suivant\n") ;
+      return ;
+    }
+  zone = close_bitstream_memory(bs, &taille) ;
+  if ( taille != sizeof(ok) || memcmp(zone, ok, taille) != 0 )
+    {
+      eprintf("Début de segment mal codé\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+void get_debut_segment_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  volatile int t ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  put_bits(bs, 5, 3) ;
+  put_debut_segment(bs, 257, 1234) ;
+  put_bit(bs, 1) ;
+  put_debut_segment(bs, 258, 0) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+
+  bs = open_bitstream_memory(zone, taille, "r") ;
+  get_bits(bs, 5) ;
+  if ( get_debut_segment(bs, 257) != 1234 )
+    {
+      eprintf("Mauvais nombre de blocs pour le segment\n") ;
+      return ;
+    }
+  get_bit(bs) ;
+  t = 0 ;
+  EXCEPTION(get_debut_segment(bs, 259) ;
+	    ,
+	    ,
+	    case Exception_marqueur_segment_invalide:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Un mauvais numéro de segment doit lancer une exception\n") ;
+      return ;
+    }
+  close_bitstream(bs) ;
+  free(zone) ;
+}
+
+void put_debut_segment_crc_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  static unsigned char ok[] = { 0x52, 0x53, 0x54, 0x02
+				, 0x80, 0x00, 0x00, 0x07, 0xA5 } ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  if ( put_debut_segment_crc(bs, 2, 7) != 0 )
+    {
+      eprintf("Le segment doit commencer au début du flot\n") ;
+      return ;
+    }
+  put_bits(bs, 8, 0xA5) ;
+  put_fin_segment(bs) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+  if ( taille != sizeof(ok) + 4 || memcmp(zone, ok, sizeof(ok)) != 0 )
+    {
+      eprintf("Début de segment avec CRC mal codé\n") ;
+      return ;
+    }
+  if ( ((unsigned)zone[9] << 24 | zone[10] << 16 | zone[11] << 8 | zone[12])
+       != crc32c(0, "\xA5", 1) )
+    {
+      eprintf("Le CRC doit porter sur les données du segment\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+void put_fin_segment_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  put_debut_segment(bs, 0, 1) ;
+  put_bits(bs, 3, 5) ;
+  put_fin_segment(bs) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+  if ( taille != 9 )
+    {
+      eprintf("Sans CRC, la fin de segment n'écrit rien\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+/*
+ * Relecture d'un segment avec CRC, intact puis abîmé.
+ */
+
+void get_fin_segment_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  volatile int t ;
+  int i ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  put_debut_segment_crc(bs, 0, 100) ;
+  for(i=0; i<100; i++)
+    put_bits(bs, 11, i * 7) ;
+  put_fin_segment(bs) ;
+  put_debut_segment(bs, 1, 0) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+
+  bs = open_bitstream_memory(zone, taille, "r") ;
+  if ( get_debut_segment(bs, 0) != 100 )
+    {
+      eprintf("Le bit AVEC_CRC ne fait pas partie du nombre de blocs\n") ;
+      return ;
+    }
+  for(i=0; i<100; i++)
+    get_bits(bs, 11) ;
+  get_fin_segment(bs) ;
+  if ( bitstream_erreur(bs) || get_debut_segment(bs, 1) != 0 )
+    {
+      eprintf("Un segment intact ne doit pas signaler d'erreur\n") ;
+      return ;
+    }
+  close_bitstream(bs) ;
+
+  zone[20] ^= 0x10 ;
+  bs = open_bitstream_memory(zone, taille, "r") ;
+  get_debut_segment(bs, 0) ;
+  for(i=0; i<100; i++)
+    get_bits(bs, 11) ;
+  t = 0 ;
+  EXCEPTION(get_fin_segment(bs) ;
+	    ,
+	    ,
+	    case Exception_somme_controle_invalide:
+	    t = 1 ;
+	    break ;
+	    ) ;
+  if ( t == 0 )
+    {
+      eprintf("Un segment abîmé doit lancer une exception\n") ;
+      return ;
+    }
+  close_bitstream(bs) ;
+  free(zone) ;
+}
+
+void put_index_segments_tst()
+{
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  static unsigned long positions[] = { 0, 0x1200123456 } ; /* > 4 Go */
+  static unsigned char ok[] = { 0xC0
+				, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+				, 0x00, 0x00, 0x00, 0x12, 0x00, 0x12, 0x34, 0x56
+				, 0x00, 0x00, 0x00, 0x02
+				, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+				, 0x52, 0x53, 0x54, 0x49 } ;
+
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  put_bits(bs, 2, 3) ;
+  put_index_segments(bs, 2, positions) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+  if ( taille != sizeof(ok) || memcmp(zone, ok, taille) != 0 )
+    {
+      eprintf("Index des segments mal codé\n") ;
+      return ;
+    }
+  free(zone) ;
+}
+
+/*
+ * On code 3 segments puis on décode le deuxième seul
+ * en partant de sa position dans l'index.
+ * Les segments d'un flot LSB se relisent sans l'en-tête ("rL").
+ */
+
+static void get_index_segments_test(const char *ecriture, const char *lecture)
+{
+  static float blocs[3][6] = { { 5, 0, 0, 7, 7, 1 }
+			       , { 0, 9, 9, 0, 0, -3 }
+			       , { 2, 2, 0, 0, 0, 0 } } ;
+  struct shannon_fano *sf ;
+  struct intstream *entier, *entier_signe ;
+  struct bitstream *bs ;
+  unsigned long positions[3], *lues ;
+  unsigned char *zone ;
+  size_t taille ;
+  float t[6] ;
+  int i ;
+
+  sf = open_shannon_fano() ;
+  bs = open_bitstream_memory(NULL, 0, ecriture) ;
+  entier = open_intstream(bs, Shannon_fano, sf) ;
+  entier_signe = open_intstream(bs, Shannon_fano, sf) ;
+  for(i=0; i<3; i++)
+    {
+      positions[i] = put_debut_segment(bs, i, 1) ;
+      reinitialise_shannon_fano(sf) ;
+      compresse(entier, entier_signe, 6, blocs[i]) ;
+    }
+  put_debut_segment(bs, 3, 0) ;
+  put_index_segments(bs, 3, positions) ;
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_shannon_fano(sf) ;
+  zone = close_bitstream_memory(bs, &taille) ;
+
+  if ( get_index_segments(zone, taille - 1, &lues) != -1 )
+    {
+      eprintf("Un flot tronqué ne doit pas avoir d'index\n") ;
+      return ;
+    }
+  if ( get_index_segments(zone, taille, &lues) != 3 )
+    {
+      eprintf("L'index doit contenir 3 segments\n") ;
+      return ;
+    }
+  for(i=0; i<3; i++)
+    if ( lues[i] != positions[i] )
+      {
+	eprintf("Mauvaise position pour le segment %d\n", i) ;
+	return ;
+      }
+
+  sf = open_shannon_fano() ;
+  bs = open_bitstream_memory(zone + lues[1], taille - lues[1], lecture) ;
+  entier = open_intstream(bs, Shannon_fano, sf) ;
+  entier_signe = open_intstream(bs, Shannon_fano, sf) ;
+  if ( get_debut_segment(bs, 1) != 1 )
+    {
+      eprintf("Le segment 1 doit contenir un bloc\n") ;
+      return ;
+    }
+  decompresse(entier, entier_signe, 6, t) ;
+  for(i=0; i<6; i++)
+    if ( t[i] != blocs[1][i] )
+      {
+	eprintf("Le segment 1 décodé seul est faux (valeur %d, mode %s)\n"
+		, i, ecriture) ;
+	return ;
+      }
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_bitstream(bs) ;
+  close_shannon_fano(sf) ;
+  free(lues) ;
+  free(zone) ;
+}
+
+void get_index_segments_tst()
+{
+  get_index_segments_test("w", "r") ;
+  get_index_segments_test("wl", "rL") ;
+}
+
+/*
+ * Un flot de 3 segments dans un fichier, relu par "mmap" :
+ * on va directement au dernier segment et on le décode.
+ */
+
+static void va_au_segment_test(const char *ecriture, const char *lecture)
+{
+  static float blocs[3][6] = { { 5, 0, 0, 7, 7, 1 }
+			       , { 0, 9, 9, 0, 0, -3 }
+			       , { 2, 2, 0, 0, 0, 0 } } ;
+  struct shannon_fano *sf ;
+  struct intstream *entier, *entier_signe ;
+  struct bitstream *bs ;
+  unsigned long positions[3] ;
+  float t[6] ;
+  int i ;
+
+  sf = open_shannon_fano() ;
+  bs = open_bitstream("xxx", ecriture) ;
+  entier = open_intstream(bs, Shannon_fano, sf) ;
+  entier_signe = open_intstream(bs, Shannon_fano, sf) ;
+  for(i=0; i<3; i++)
+    {
+      positions[i] = put_debut_segment(bs, i, 1) ;
+      reinitialise_shannon_fano(sf) ;
+      compresse(entier, entier_signe, 6, blocs[i]) ;
+    }
+  put_debut_segment(bs, 3, 0) ;
+  put_index_segments(bs, 3, positions) ;
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_bitstream(bs) ;
+
+  bs = open_bitstream("xxx", lecture) ;
+  if ( va_au_segment(bs, 2) != -1 )
+    {
+      eprintf("va_au_segment : le flot n'est pas en mémoire\n") ;
+      return ;
+    }
+  close_bitstream(bs) ;
+
+  bs = open_bitstream_mmap("xxx", lecture) ;
+  if ( va_au_segment(bs, 3) != -1 || va_au_segment(bs, -1) != -1 )
+    {
+      eprintf("va_au_segment : ce segment n'existe pas\n") ;
+      return ;
+    }
+  entier = open_intstream(bs, Shannon_fano, sf) ;
+  entier_signe = open_intstream(bs, Shannon_fano, sf) ;
+  reinitialise_shannon_fano(sf) ;
+  if ( va_au_segment(bs, 2) != 0
+       || bitstream_tell_bits(bs) != 8 * positions[2]
+       || get_debut_segment(bs, 2) != 1 )
+    {
+      eprintf("va_au_segment ne trouve pas le segment 2 (mode %s)\n"
+	      , lecture) ;
+      return ;
+    }
+  decompresse(entier, entier_signe, 6, t) ;
+  for(i=0; i<6; i++)
+    if ( t[i] != blocs[2][i] )
+      {
+	eprintf("Le segment 2 décodé seul est faux (valeur %d, mode %s)\n"
+		, i, lecture) ;
+	return ;
+      }
+  if ( get_debut_segment(bs, 3) != 0 || bitstream_erreur(bs) )
+    {
+      eprintf("Après le segment 2, il doit y avoir le segment vide\n") ;
+      return ;
+    }
+  close_intstream(entier) ;
+  close_intstream(entier_signe) ;
+  close_bitstream(bs) ;
+  close_shannon_fano(sf) ;
+}
+
+void va_au_segment_tst()
+{
+  va_au_segment_test("w", "r") ;
+  va_au_segment_test("wl", "rl") ;
 }
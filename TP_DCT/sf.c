@@ -7,23 +7,373 @@
  */
 
 
+#include <limits.h>
 #include "bits.h"
 #include "sf.h"
 
 #define VALEUR_ESCAPE 0x7fffffff /* Plus grand entier positif */
+#define BITS_PREMIER  10	/* Table de décodage de 1024 cases */
 
-struct evenement
+/*
+ * Suite de positions consécutives de même nombre d'occurrences
+ */
+struct bloc
+ {
+  int tete ;			/* Première position */
+  int taille ;			/* Nombre de positions */
+ } ;
+
+/*
+ * Code d'un événement figé à la dernière reconstruction
+ * (voir "shannon_fano_periode").
+ */
+struct code
  {
   int valeur ;
-  int nb_occurrences  ;
+  unsigned int longueur ;
+  unsigned long bits ;		/* Les "longueur" bits de droite */
+  unsigned long bits_lsb ;	/* Les mêmes dans l'ordre inverse */
+  unsigned long gauche ;	/* Les mêmes cadrés à gauche */
  } ;
 
 struct shannon_fano
  {
+  unsigned long nb_escapes ;	/* Pour les statistiques */
+  int *index ;			/* Table de hachage (voir "trouve_position") */
+  int taille_index ;		/* Puissance de 2, NULL/0 si pas construite */
+  unsigned int decalage_index ;	/* 32 - log2(taille_index) */
+  long *cumuls ;		/* Arbre de Fenwick (voir "trouve_separation") */
+  int taille_cumuls ;		/* Puissance de 2 */
+  int *bloc ;			/* Bloc de chaque position */
+  struct bloc *blocs ;		/* Voir "incremente_et_ordonne" */
+  int *blocs_libres ;		/* Pile des numéros de bloc libres */
+  int nb_blocs_libres ;
+  int taille_blocs ;
+  long seuil ;			/* Voir "vieillit", 0 : pas de vieillissement */
+  int periode ;			/* 0 : codes recalculés à chaque symbole */
+  unsigned long nb_symboles ;	/* Depuis l'ouverture ou la réinitialisation */
+  unsigned long prochaine_reconstruction ; /* Valeur de "nb_symboles" */
+  struct code *codes ;		/* Positions de la dernière reconstruction */
+  int nb_codes ;
+  int code_escape ;		/* Numéro du code de ESCAPE */
+  int *numero ;			/* Numéro de l'événement de chaque position */
+  int *position_du_numero ;	/* Et inversement */
+  int nb_numeros ;
+  int *index_codes ;		/* Valeur --> numéro (voir "cherche_numero") */
+  int taille_index_codes ;
+  unsigned int decalage_codes ;	/* 32 - log2(taille_index_codes) */
+  int *premier ;			/* Voir "decode_code", NULL si pas périodique */
   int nb_evenements ;
-  struct evenement evenements[200000] ;
+  int taille_evenements ;	/* Nombre de places allouées */
+  int nb_evenements_max ;	/* Au-delà les nouvelles valeurs sont ESCAPE */
+  int *valeurs ;		/* Valeur de chaque position */
+  int *nb_occurrences ;		/* Triées par ordre décroissant */
  } ;
 
+static void reconstruit_codes(struct shannon_fano *sf) ;
+static void numerote_dernier(struct shannon_fano *sf) ;
+
+/*
+ * Index des positions pour le codeur.
+ *
+ * C'est une table de hachage à adressage ouvert (sondage linéaire)
+ * dont les cases contiennent la position d'un événement dans
+ * la table (ou -1 si la case est libre) : la valeur est lue
+ * dans "valeurs". Chaque position est dans une seule case,
+ * même si deux événements ont la même valeur.
+ * La table est remplie au plus à moitié, elle double sinon.
+ * Le hachage multiplicatif (Fibonacci) garde les bits de gauche
+ * du produit : ceux de droite ne dépendent que des bits de droite
+ * de la valeur et des valeurs espacées d'une puissance de 2
+ * tomberaient toutes dans la même case.
+ *
+ * Elle est construite à la première écriture : le décodeur
+ * ne l'utilise pas et n'a pas à la maintenir.
+ */
+
+#define TAILLE_INDEX_MIN 128	/* Deux fois TAILLE_EVENEMENTS_MIN */
+
+static inline unsigned int hache(const struct shannon_fano *sf, int valeur)
+{
+  return ((unsigned int)valeur * 2654435769u) >> sf->decalage_index ;
+}
+
+/*
+ * Case contenant "position" (qui doit être dans l'index).
+ */
+static int case_de_position(const struct shannon_fano *sf, int position)
+{
+  unsigned int h ;
+
+  h = hache(sf, sf->valeurs[position]) ;
+  while( sf->index[h] != position )
+    h = (h + 1) & (sf->taille_index - 1) ;
+  return h ;
+}
+
+static void indexe(struct shannon_fano *sf, int position)
+{
+  unsigned int h ;
+
+  h = hache(sf, sf->valeurs[position]) ;
+  while( sf->index[h] != -1 )
+    h = (h + 1) & (sf->taille_index - 1) ;
+  sf->index[h] = position ;
+}
+
+/*
+ * (Re)construit l'index pour "taille" cases.
+ */
+static void construit_index(struct shannon_fano *sf, int taille)
+{
+  int i ;
+
+  free(sf->index) ;
+  ALLOUER(sf->index, taille) ;
+  sf->taille_index = taille ;
+  sf->decalage_index = 32 - __builtin_ctz(taille) ;
+  memset(sf->index, -1, taille * sizeof(*sf->index)) ;
+  for(i=0; i<sf->nb_evenements; i++)
+    indexe(sf, i) ;
+}
+
+/*
+ * Ajoute à l'index le dernier événement de la table.
+ */
+static void indexe_dernier(struct shannon_fano *sf)
+{
+  if ( sf->index == NULL )
+    return ;
+  if ( 2 * sf->nb_evenements > sf->taille_index )
+    construit_index(sf, 2 * sf->taille_index) ;
+  else
+    indexe(sf, sf->nb_evenements - 1) ;
+}
+
+/*
+ * Sommes cumulées des occurrences.
+ *
+ * C'est un arbre de Fenwick : la case "k" (de 1 à "taille_cumuls")
+ * contient la somme des occurrences des positions k-(k&-k) à k-1.
+ * Les positions au-delà de "nb_evenements" ont 0 occurrence.
+ * La somme d'un préfixe, la mise à jour d'une occurrence et
+ * la recherche d'un préfixe atteignant une somme sont en O(log n).
+ */
+
+static void ajoute_cumul(struct shannon_fano *sf, int position, long delta)
+{
+  int k ;
+
+  for(k = position + 1 ; k <= sf->taille_cumuls ; k += k & -k)
+    sf->cumuls[k] += delta ;
+}
+
+/*
+ * Somme des occurrences des positions 0 à "position" incluse.
+ */
+static long cumul(const struct shannon_fano *sf, int position)
+{
+  long somme ;
+  int k ;
+
+  somme = 0 ;
+  for(k = position + 1 ; k > 0 ; k -= k & -k)
+    somme += sf->cumuls[k] ;
+  return somme ;
+}
+
+/*
+ * Plus petite position dont le cumul atteint "somme" (> 0).
+ */
+static int position_du_cumul(const struct shannon_fano *sf, long somme)
+{
+  int position, pas ;
+
+  position = 0 ;
+  for(pas = sf->taille_cumuls ; pas ; pas /= 2)
+    if ( position + pas <= sf->taille_cumuls
+	 && sf->cumuls[position + pas] < somme )
+      {
+	position += pas ;
+	somme -= sf->cumuls[position] ;
+      }
+  return position ;
+}
+
+/*
+ * (Re)construit l'arbre pour "taille" positions, en O(taille).
+ */
+static void construit_cumuls(struct shannon_fano *sf, int taille)
+{
+  int k ;
+
+  free(sf->cumuls) ;
+  ALLOUER(sf->cumuls, taille + 1) ;
+  sf->taille_cumuls = taille ;
+  memset(sf->cumuls, 0, (taille + 1) * sizeof(*sf->cumuls)) ;
+  for(k=1; k<=sf->nb_evenements; k++)
+    sf->cumuls[k] = sf->nb_occurrences[k-1] ;
+  for(k=1; k<=taille; k++)
+    if ( k + (k & -k) <= taille )
+      sf->cumuls[k + (k & -k)] += sf->cumuls[k] ;
+}
+
+/*
+ * Blocs d'occurrences égales.
+ *
+ * La table étant triée, les événements de même nombre d'occurrences
+ * sont consécutifs : ils forment un bloc dont on connaît la tête.
+ * "bloc[position]" est le numéro du bloc contenant la position.
+ */
+
+static int nouveau_bloc(struct shannon_fano *sf, int tete)
+{
+  int b ;
+
+  b = sf->blocs_libres[--sf->nb_blocs_libres] ;
+  sf->blocs[b].tete = tete ;
+  sf->blocs[b].taille = 0 ;
+  return b ;
+}
+
+/*
+ * Met "position" dans le bloc de la position précédente
+ * s'il a le même nombre d'occurrences, dans un nouveau bloc sinon.
+ */
+static void range_dans_bloc(struct shannon_fano *sf, int position)
+{
+  int b ;
+
+  if ( position > 0 && sf->nb_occurrences[position-1]
+       == sf->nb_occurrences[position] )
+    b = sf->bloc[position-1] ;
+  else
+    b = nouveau_bloc(sf, position) ;
+  sf->bloc[position] = b ;
+  sf->blocs[b].taille++ ;
+}
+
+/*
+ * (Re)construit les blocs pour "taille" positions, en O(taille).
+ */
+static void construit_blocs(struct shannon_fano *sf, int taille)
+{
+  int i ;
+
+  free(sf->bloc) ;
+  free(sf->blocs) ;
+  free(sf->blocs_libres) ;
+  ALLOUER(sf->bloc, taille) ;
+  ALLOUER(sf->blocs, taille) ;
+  ALLOUER(sf->blocs_libres, taille) ;
+  sf->taille_blocs = taille ;
+  for(i=0; i<taille; i++)
+    sf->blocs_libres[i] = taille - 1 - i ;
+  sf->nb_blocs_libres = taille ;
+  for(i=0; i<sf->nb_evenements; i++)
+    range_dans_bloc(sf, i) ;
+}
+
+/*
+ * Les valeurs et les occurrences sont dans deux tableaux :
+ * les recherches ne parcourent que celui dont elles ont besoin.
+ * Ils commencent petits (une image simple a peu de valeurs)
+ * et doublent quand ils sont pleins, l'arbre des cumuls et les blocs
+ * ont toujours la même taille qu'eux ("taille_evenements").
+ */
+
+#define TAILLE_EVENEMENTS_MIN 64
+
+static void agrandit_evenements(struct shannon_fano *sf, int taille)
+{
+  int *valeurs, *nb_occurrences ;
+
+  valeurs = realloc(sf->valeurs, taille * sizeof(*valeurs)) ;
+  if ( valeurs )
+    sf->valeurs = valeurs ;
+  nb_occurrences = realloc(sf->nb_occurrences
+			   , taille * sizeof(*nb_occurrences)) ;
+  if ( nb_occurrences )
+    sf->nb_occurrences = nb_occurrences ;
+  if ( valeurs == NULL || nb_occurrences == NULL )
+    {
+      fprintf(stderr, "Plus de memoire\n") ;
+      EXIT ;
+    }
+  sf->taille_evenements = taille ;
+  if ( sf->numero )
+    {
+      sf->numero = realloc(sf->numero, taille * sizeof(*sf->numero)) ;
+      sf->position_du_numero = realloc(sf->position_du_numero
+				       , taille * sizeof(*sf->numero)) ;
+      if ( sf->numero == NULL || sf->position_du_numero == NULL )
+	{
+	  fprintf(stderr, "Plus de memoire\n") ;
+	  EXIT ;
+	}
+    }
+}
+
+/*
+ * Ajoute l'événement "valeur" (une occurrence) en fin de table.
+ * Si la table a atteint "nb_evenements_max" la valeur n'est pas
+ * ajoutée : elle restera codée par ESCAPE.
+ * Le codeur et le décodeur font le même choix.
+ */
+static void ajoute_evenement(struct shannon_fano *sf, int valeur)
+{
+  if ( sf->nb_evenements >= sf->nb_evenements_max )
+    return ;
+  if ( sf->nb_evenements == sf->taille_evenements )
+    agrandit_evenements(sf, 2 * sf->taille_evenements) ;
+  sf->valeurs[sf->nb_evenements] = valeur ;
+  sf->nb_occurrences[sf->nb_evenements] = 1 ;
+  sf->nb_evenements++ ;
+  indexe_dernier(sf) ;
+  if ( sf->periode )
+    numerote_dernier(sf) ;
+  if ( sf->taille_cumuls != sf->taille_evenements )
+    construit_cumuls(sf, sf->taille_evenements) ;
+  else
+    ajoute_cumul(sf, sf->nb_evenements - 1, 1) ;
+  if ( sf->taille_blocs != sf->taille_evenements )
+    construit_blocs(sf, sf->taille_evenements) ;
+  else
+    range_dans_bloc(sf, sf->nb_evenements - 1) ;
+}
+
+/*
+ * Echange deux événements de la table en tenant les index à jour.
+ */
+static void echange(struct shannon_fano *sf, int i, int j)
+{
+  int ci, cj, v, n ;
+
+  if ( sf->index )
+    {
+      ci = case_de_position(sf, i) ;
+      cj = case_de_position(sf, j) ;
+      sf->index[ci] = j ;
+      sf->index[cj] = i ;
+    }
+  v = sf->valeurs[i] ;
+  sf->valeurs[i] = sf->valeurs[j] ;
+  sf->valeurs[j] = v ;
+  n = sf->nb_occurrences[i] ;
+  sf->nb_occurrences[i] = sf->nb_occurrences[j] ;
+  sf->nb_occurrences[j] = n ;
+  ajoute_cumul(sf, i, sf->nb_occurrences[i] - n) ;
+  ajoute_cumul(sf, j, n - sf->nb_occurrences[i]) ;
+  if ( sf->periode )
+    {
+      n = sf->numero[i] ;
+      sf->numero[i] = sf->numero[j] ;
+      sf->numero[j] = n ;
+      sf->position_du_numero[sf->numero[i]] = i ;
+      sf->position_du_numero[n] = j ;
+    }
+}
+
 
 /*
  * Allocation des la structure et remplissage des champs pour initialiser
@@ -33,45 +383,105 @@ struct shannon_fano* open_shannon_fano()
 {
     struct shannon_fano *s;
     ALLOUER(s,1);
+    s->nb_escapes = 0;
+    s->index = NULL;
+    s->taille_index = 0;
+    s->cumuls = NULL;
+    s->bloc = NULL;
+    s->blocs = NULL;
+    s->blocs_libres = NULL;
+    s->seuil = 0;
+    s->periode = 0;
+    s->nb_symboles = 0;
+    s->prochaine_reconstruction = 1;
+    s->codes = NULL;
+    s->premier = NULL;
+    s->nb_codes = 0;
+    s->numero = NULL;
+    s->position_du_numero = NULL;
+    s->index_codes = NULL;
+    s->taille_index_codes = 0;
+    s->valeurs = NULL;
+    s->nb_occurrences = NULL;
+    agrandit_evenements(s, TAILLE_EVENEMENTS_MIN);
+    s->nb_evenements_max = INT_MAX;
     s->nb_evenements = 1;
-    s->evenements[0].valeur = VALEUR_ESCAPE;
-    s->evenements[0].nb_occurrences = 1;
+    s->valeurs[0] = VALEUR_ESCAPE;
+    s->nb_occurrences[0] = 1;
+    construit_cumuls(s, s->taille_evenements);
+    construit_blocs(s, s->taille_evenements);
     return s ; /* pour enlever un warning du compilateur */
 }
 
+/*
+ * Remet la table dans l'état de "open_shannon_fano" :
+ * seul l'événement ESCAPE reste, avec une occurrence.
+ * Utilisé aux marqueurs de reprise pour que chaque segment
+ * puisse être décodé sans connaître les précédents.
+ */
+void reinitialise_shannon_fano(struct shannon_fano *sf)
+{
+    sf->nb_evenements = 1;
+    agrandit_evenements(sf, TAILLE_EVENEMENTS_MIN);	/* Rend la mémoire */
+    sf->valeurs[0] = VALEUR_ESCAPE;
+    sf->nb_occurrences[0] = 1;
+    if ( sf->index )
+      construit_index(sf, TAILLE_INDEX_MIN);
+    construit_cumuls(sf, sf->taille_evenements);
+    construit_blocs(sf, sf->taille_evenements);
+    sf->nb_symboles = 0;
+    sf->prochaine_reconstruction = 1;
+    if ( sf->periode )
+      reconstruit_codes(sf);
+}
+
 /*
  * Fermeture (libération mémoire)
  */
 void close_shannon_fano(struct shannon_fano *sf)
 {
     //fprintf( stderr, "Close roi ! --- \n");
+    free(sf->index);
+    free(sf->cumuls);
+    free(sf->bloc);
+    free(sf->blocs);
+    free(sf->blocs_libres);
+    free(sf->codes);
+    free(sf->premier);
+    free(sf->numero);
+    free(sf->position_du_numero);
+    free(sf->index_codes);
+    free(sf->valeurs);
+    free(sf->nb_occurrences);
     free(sf);
 }
 
 /*
  * En entrée l'événement (sa valeur, pas son code shannon-fano).
- * En sortie la position de l'événement dans le tableau "evenements"
+ * En sortie la position de l'événement dans la table
  * Si l'événement n'est pas trouvé, on retourne la position
  * de l'événement ESCAPE.
+ *
+ * On cherche dans l'index (temps constant) et non dans le tableau.
  */
 
-static int trouve_position(const struct shannon_fano *sf, int evenement)
+static int trouve_position(struct shannon_fano *sf, int evenement)
 {
-  int escape_pos = 0;
-  for(unsigned int i=0; i< sf->nb_evenements; i++){
-
-    if(sf->evenements[i].valeur == VALEUR_ESCAPE)
-            escape_pos = i ;
-    if(sf->evenements[i].valeur == evenement){
-            return i;
-    }
-  }
-            return escape_pos ; /* pour enlever un warning du compilateur */
+  unsigned int h ;
 
+  if ( sf->index == NULL )
+    construit_index(sf, TAILLE_INDEX_MIN) ;
+  for(h = hache(sf, evenement) ; sf->index[h] != -1 ;
+      h = (h + 1) & (sf->taille_index - 1))
+    if ( sf->valeurs[sf->index[h]] == evenement )
+      return sf->index[h] ;
+  if ( evenement == VALEUR_ESCAPE )
+    EXIT ;
+  return trouve_position(sf, VALEUR_ESCAPE) ;
 }
 
 /*
- * Soit le sous-tableau "evenements[position_min..position_max]"
+ * Soit le sous-tableau des positions "position_min..position_max"
  * Les bornes sont incluses.
  *
  * LES FORTES OCCURRENCES SONT LES PETITS INDICES DU TABLEAU
@@ -89,72 +499,86 @@ static int trouve_separation(const struct shannon_fano *sf
 			     , int position_min
 			     , int position_max)
 {
+  long avant, somme, gauche, ecart, ecart_precedent ;
+  int i ;
 
-  int sum = 0;
-  for(int i=position_min ; i <position_max+1 ; i++)
-    {
-      sum += sf->evenements[i].nb_occurrences;
-    }
-
-  int rightSum = 0;
-  int min = sum;
-  int index = -1;
-
-  for(int i=position_min; i<position_max+1; i++)
-  {
-    sum -= sf->evenements[i].nb_occurrences;
-    rightSum += sf->evenements[i].nb_occurrences;
-
-    if(abs(rightSum - sum) < min)
+  /*
+   * L'écart |gauche - droite| = |2*gauche - somme| décroît puis croît
+   * avec la position. Le minimum est à la première position "i"
+   * telle que 2*gauche >= somme ou juste avant : deux recherches
+   * dans les cumuls au lieu de parcourir le sous-tableau.
+   * Comme la boucle d'origine, on prend la première position
+   * de l'écart minimum et seulement s'il est inférieur à la somme.
+   */
+  avant = position_min ? cumul(sf, position_min - 1) : 0 ;
+  somme = cumul(sf, position_max) - avant ;
+  i = position_du_cumul(sf, avant + (somme + 1) / 2) ;
+  gauche = cumul(sf, i) - avant ;
+  ecart = 2 * gauche - somme ;
+  if ( i > position_min )
     {
-        min = abs(rightSum - sum);
-        index = i;
+      ecart_precedent = somme - 2 * (gauche - sf->nb_occurrences[i]) ;
+      if ( ecart_precedent <= ecart )
+	{
+	  if ( ecart_precedent >= somme )
+	    return -1 ;
+	  /* Première position de même cumul (s'il y a des 0 occurrence) */
+	  return position_du_cumul(sf, cumul(sf, i - 1)) ;
+	}
     }
-  }
-
-  return index;
+  return ecart < somme ? i : -1 ;
 }
 
 /*
  * Cette fonction (simplement itérative)
  * utilise "trouve_separation" pour générer les bons bit dans "bs"
- * le code de l'événement "sf->evenements[position]".
+ * le code de l'événement la position "position".
+ *
+ * Les bits sont accumulés dans "code" et écrits par paquets
+ * de 32 au plus : un "put_bits" au lieu d'un "put_bit" par bit.
+ * En LSB le premier bit du paquet est celui de droite.
  */
 
 static void encode_position(struct bitstream *bs,struct shannon_fano *sf,
 		     int position)
 {
-
     int pos_min = 0;
     int pos_max = sf->nb_evenements-1;
+    unsigned long code = 0;
+    unsigned int longueur = 0;
+    Booleen bit;
 
     while(pos_min != pos_max)
     {
       int pos = trouve_separation(sf, pos_min, pos_max);
       if(pos == -1){
-          put_bit(bs, Faux);
-          //fprintf( stderr, "-1");
-          return;
+          bit = Faux;
+          pos_max = pos_min;	/* Dernier bit */
         }
-      if(position > pos){
+      else if(position > pos){
         pos_min = pos + 1;
-        put_bit(bs, Vrai);
-        //fprintf( stderr, "1");
-
+        bit = Vrai;
       }
       else{
         pos_max = pos;
-        put_bit(bs, Faux);
-        //fprintf( stderr, "0");
-
+        bit = Faux;
+      }
+      if(bitstream_lsb(bs))
+        code |= (unsigned long)bit << longueur;
+      else
+        code = code << 1 | bit;
+      if(++longueur == 32){
+        put_bits(bs, longueur, code);
+        code = 0;
+        longueur = 0;
       }
     }
-    //fprintf( stderr, "\n");
+    put_bits(bs, longueur, code);
 }
 
 /*
  * Cette fonction incrémente le nombre d'occurrence de
- * "sf->evenements[position]"
+ * la position "position"
  * Puis elle modifie le tableau pour qu'il reste trié par nombre
  * d'occurrence (un simple échange d'événement suffit)
  *
@@ -163,19 +587,345 @@ static void encode_position(struct bitstream *bs,struct shannon_fano *sf,
 
 static void incremente_et_ordonne(struct shannon_fano *sf, int position)
 {
+  int b, tete ;
 
-      sf->evenements[position].nb_occurrences++;
+  /*
+   * L'événement passe en tête de son bloc (le premier événement
+   * qui a moins d'occurrences que lui après l'incrément),
+   * puis il quitte ce bloc pour rejoindre celui d'avant
+   * s'il a maintenant autant d'occurrences : tout est en O(1).
+   */
+  b = sf->bloc[position] ;
+  tete = sf->blocs[b].tete ;
+  if ( tete != position )
+    echange(sf, position, tete) ;
+  sf->nb_occurrences[tete]++ ;
+  ajoute_cumul(sf, tete, 1) ;
+  sf->blocs[b].tete++ ;
+  if ( --sf->blocs[b].taille == 0 )
+    sf->blocs_libres[sf->nb_blocs_libres++] = b ;
+  range_dans_bloc(sf, tete) ;
+}
 
-      for(int i=0; i<position; i++)
-      {
-        if(sf->evenements[position].nb_occurrences > sf->evenements[i].nb_occurrences)
-            {
-                struct evenement save = sf->evenements[position];
-                sf->evenements[position] = sf->evenements[i];
-                sf->evenements[i] = save;
-                break;
-            }
-       }
+/*
+ * Quand le total des occurrences dépasse "seuil", elles sont toutes
+ * divisées par 2 : les anciens symboles comptent de moins en moins
+ * et la table suit les changements de statistique.
+ * Arrondir au-dessus garde au moins une occurrence et l'ordre
+ * décroissant (des égalités peuvent apparaître : les blocs
+ * et l'arbre sont reconstruits, l'index ne change pas).
+ *
+ * C'est fait après chaque symbole complet (codé ou décodé),
+ * le codeur et le décodeur le font donc au même moment.
+ * Le seuil est au moins deux fois le nombre d'événements :
+ * il reste au moins un quart du seuil à compter avant la division
+ * suivante, qui coûte O(nb_evenements).
+ */
+static void vieillit(struct shannon_fano *sf)
+{
+  int i ;
+
+  /* La racine de l'arbre de Fenwick est le total */
+  if ( sf->seuil == 0 || sf->cumuls[sf->taille_cumuls]
+       <= MAX(sf->seuil, 2L * sf->nb_evenements) )
+    return ;
+  for(i=0; i<sf->nb_evenements; i++)
+    sf->nb_occurrences[i] = (sf->nb_occurrences[i] + 1) / 2 ;
+  construit_cumuls(sf, sf->taille_cumuls) ;
+  construit_blocs(sf, sf->taille_blocs) ;
+}
+
+/*
+ * Reconstruction périodique des codes (voir "shannon_fano_periode").
+ *
+ * Les codes de toutes les positions sont calculés d'un coup
+ * en découpant la table comme "encode_position", puis figés jusqu'à
+ * la reconstruction suivante. Entre deux reconstructions la table
+ * (occurrences et ordre) est tenue à jour comme d'habitude,
+ * mais les symboles sont codés avec les codes figés :
+ *    - le codeur trouve le code de la valeur dans "index_codes",
+ *    - le décodeur trouve le code dans "codes" trié par "gauche" :
+ *      "premier" donne l'intervalle à chercher pour les
+ *      BITS_PREMIER premiers bits (souvent un seul code).
+ *
+ * Une valeur apparue depuis la reconstruction n'a pas encore de code,
+ * elle est envoyée comme une nouvelle (ESCAPE puis la valeur)
+ * et le décodeur la retrouve dans la table si elle y est.
+ *
+ * Chaque événement a un numéro qui ne change pas quand il se déplace
+ * dans la table : celui de son code, ou à la suite pour ceux ajoutés
+ * depuis la reconstruction. "index_codes" (valeur --> numéro) n'est
+ * donc modifié que par les ajouts et "position_du_numero" donne
+ * la position courante : ni le codeur ni le décodeur n'ont besoin
+ * de l'index des positions ("trouve_position").
+ *
+ * La reconstruction est faite après les symboles 1, 2, 4, 8...
+ * puis tous les "periode" symboles, au même moment des deux côtés.
+ * Avec une période de 1 le flot est celui du mode normal.
+ */
+
+#define LONGUEUR_CODE_MAX 56	/* Ce que "peek_bits" peut regarder */
+
+static unsigned long inverse_bits(unsigned long x)
+{
+  x = (x >> 1 & 0x5555555555555555ul) | (x & 0x5555555555555555ul) << 1 ;
+  x = (x >> 2 & 0x3333333333333333ul) | (x & 0x3333333333333333ul) << 2 ;
+  x = (x >> 4 & 0x0F0F0F0F0F0F0F0Ful) | (x & 0x0F0F0F0F0F0F0F0Ful) << 4 ;
+  return __builtin_bswap64(x) ;
+}
+
+static inline unsigned int hache_code(const struct shannon_fano *sf
+				      , int valeur)
+{
+  return ((unsigned int)valeur * 2654435769u) >> sf->decalage_codes ;
+}
+
+static void indexe_numero(struct shannon_fano *sf, int k)
+{
+  unsigned int h ;
+
+  h = hache_code(sf, sf->valeurs[sf->position_du_numero[k]]) ;
+  while( sf->index_codes[h] != -1 )
+    h = (h + 1) & (sf->taille_index_codes - 1) ;
+  sf->index_codes[h] = k ;
+}
+
+/*
+ * (Re)construit "index_codes" pour "taille" cases.
+ */
+static void construit_index_codes(struct shannon_fano *sf, int taille)
+{
+  int k ;
+
+  if ( taille != sf->taille_index_codes )
+    {
+      free(sf->index_codes) ;
+      ALLOUER(sf->index_codes, taille) ;
+      sf->taille_index_codes = taille ;
+      sf->decalage_codes = 32 - __builtin_ctz(taille) ;
+    }
+  memset(sf->index_codes, -1, taille * sizeof(*sf->index_codes)) ;
+  for(k=0; k<sf->nb_numeros; k++)
+    indexe_numero(sf, k) ;
+}
+
+/*
+ * Numérote le dernier événement de la table (il vient d'être ajouté).
+ */
+static void numerote_dernier(struct shannon_fano *sf)
+{
+  int k ;
+
+  k = sf->nb_numeros++ ;
+  sf->numero[sf->nb_evenements - 1] = k ;
+  sf->position_du_numero[k] = sf->nb_evenements - 1 ;
+  if ( 2 * sf->nb_numeros > sf->taille_index_codes )
+    construit_index_codes(sf, 2 * sf->taille_index_codes) ;
+  else
+    indexe_numero(sf, k) ;
+}
+
+/*
+ * Numéro de "valeur", -1 si elle n'est pas dans la table.
+ * Il a un code s'il est inférieur à "nb_codes".
+ */
+static int cherche_numero(const struct shannon_fano *sf, int valeur)
+{
+  unsigned int h ;
+
+  for(h = hache_code(sf, valeur) ; sf->index_codes[h] != -1 ;
+      h = (h + 1) & (sf->taille_index_codes - 1))
+    if ( sf->valeurs[sf->position_du_numero[sf->index_codes[h]]] == valeur )
+      return sf->index_codes[h] ;
+  return -1 ;
+}
+
+static void calcule_codes(struct shannon_fano *sf, int min, int max
+			  , unsigned long bits, unsigned int longueur)
+{
+  struct code *c ;
+  int separation ;
+
+  if ( min == max )
+    {
+      c = &sf->codes[min] ;
+      c->valeur = sf->valeurs[min] ;
+      c->longueur = longueur ;
+      c->bits = bits ;
+      c->bits_lsb = longueur ? inverse_bits(bits) >> (64 - longueur) : 0 ;
+      c->gauche = longueur ? bits << (64 - longueur) : 0 ;
+      return ;
+    }
+  separation = trouve_separation(sf, min, max) ;
+  /* Impossible tant que les occurrences tiennent dans un "int" */
+  if ( separation < 0 || longueur == LONGUEUR_CODE_MAX )
+    EXIT ;
+  calcule_codes(sf, min, separation, bits << 1, longueur + 1) ;
+  calcule_codes(sf, separation + 1, max, bits << 1 | 1, longueur + 1) ;
+}
+
+static void reconstruit_codes(struct shannon_fano *sf)
+{
+  int j, t, taille ;
+
+  if ( sf->nb_evenements > sf->nb_codes )
+    {
+      free(sf->codes) ;
+      ALLOUER(sf->codes, sf->nb_evenements) ;
+    }
+  sf->nb_codes = sf->nb_evenements ;
+  calcule_codes(sf, 0, sf->nb_codes - 1, 0, 0) ;
+
+  if ( sf->numero == NULL )
+    {
+      ALLOUER(sf->numero, sf->taille_evenements) ;
+      ALLOUER(sf->position_du_numero, sf->taille_evenements) ;
+    }
+  for(j=0; j<sf->nb_codes; j++)
+    {
+      sf->numero[j] = j ;
+      sf->position_du_numero[j] = j ;
+      if ( sf->codes[j].valeur == VALEUR_ESCAPE )
+	sf->code_escape = j ;
+    }
+  sf->nb_numeros = sf->nb_codes ;
+  for(taille = TAILLE_INDEX_MIN ; taille < 2 * sf->nb_codes ; taille *= 2)
+    ;
+  construit_index_codes(sf, taille) ;
+
+  if ( sf->premier == NULL )
+    ALLOUER(sf->premier, (1 << BITS_PREMIER) + 1) ;
+  for(j=0, t=0; t < 1 << BITS_PREMIER; t++)
+    {
+      while( j + 1 < sf->nb_codes && sf->codes[j + 1].gauche
+	     <= (unsigned long)t << (64 - BITS_PREMIER) )
+	j++ ;
+      sf->premier[t] = j ;
+    }
+  sf->premier[1 << BITS_PREMIER] = sf->nb_codes - 1 ;
+}
+
+/*
+ * Le code "j" est celui dont l'intervalle [gauche, gauche + 2^(64-longueur)[
+ * contient les prochains bits du flot : le plus grand "gauche" inférieur.
+ */
+static int decode_code(struct bitstream *bs, const struct shannon_fano *sf)
+{
+  unsigned long x ;
+  int bas, haut, milieu ;
+
+  if ( sf->nb_codes == 1 )
+    return 0 ;
+  x = peek_bits(bs, LONGUEUR_CODE_MAX) ;
+  x = bitstream_lsb(bs) ? inverse_bits(x) : x << (64 - LONGUEUR_CODE_MAX) ;
+  bas = sf->premier[x >> (64 - BITS_PREMIER)] ;
+  haut = sf->premier[(x >> (64 - BITS_PREMIER)) + 1] ;
+  while( bas < haut )
+    {
+      milieu = (bas + haut + 1) / 2 ;
+      if ( sf->codes[milieu].gauche <= x )
+	bas = milieu ;
+      else
+	haut = milieu - 1 ;
+    }
+  skip_bits(bs, sf->codes[bas].longueur) ;
+  return bas ;
+}
+
+static void symbole_code(struct shannon_fano *sf)
+{
+  if ( ++sf->nb_symboles >= sf->prochaine_reconstruction )
+    {
+      reconstruit_codes(sf) ;
+      sf->prochaine_reconstruction = sf->nb_symboles
+	+ MIN((unsigned long)sf->periode, sf->nb_symboles) ;
+    }
+}
+
+/*
+ * Après "valeur" (codée ou décodée) de numéro "k" (-1 si elle n'est
+ * pas dans la table) on met à jour la table exactement comme
+ * en mode normal.
+ */
+static void compte_valeur(struct shannon_fano *sf, int valeur, int k)
+{
+  int position ;
+
+  if ( k < 0 )
+    {
+      position = sf->position_du_numero[sf->code_escape] ;
+      ajoute_evenement(sf, valeur) ;
+    }
+  else
+    position = sf->position_du_numero[k] ;
+  incremente_et_ordonne(sf, position) ;
+  vieillit(sf) ;
+  symbole_code(sf) ;
+}
+
+static void put_entier_periodique(struct bitstream *bs
+				  , struct shannon_fano *sf, int evenement)
+{
+  const struct code *c ;
+  int k ;
+
+  k = cherche_numero(sf, evenement) ;
+  c = &sf->codes[k >= 0 && k < sf->nb_codes ? k : sf->code_escape] ;
+  put_bits(bs, c->longueur, bitstream_lsb(bs) ? c->bits_lsb : c->bits) ;
+  if ( c->valeur == VALEUR_ESCAPE )
+    {
+      sf->nb_escapes++ ;
+      put_bits(bs, sizeof(int)*8, evenement) ;
+    }
+  compte_valeur(sf, evenement, k) ;
+}
+
+static int get_entier_periodique(struct bitstream *bs
+				 , struct shannon_fano *sf)
+{
+  int valeur, k ;
+
+  k = decode_code(bs, sf) ;
+  valeur = sf->codes[k].valeur ;
+  if ( valeur == VALEUR_ESCAPE )
+    {
+      sf->nb_escapes++ ;
+      valeur = get_bits(bs, sizeof(int)*8) ;
+      k = cherche_numero(sf, valeur) ;
+    }
+  compte_valeur(sf, valeur, k) ;
+  return valeur ;
+}
+
+/*
+ * Limite la table à "max" événements (ESCAPE compris, au moins 1).
+ * Sans limite elle grandit autant qu'il faut.
+ * Le codeur et le décodeur doivent avoir la même limite.
+ */
+void shannon_fano_nb_evenements_max(struct shannon_fano *sf, int max)
+{
+  sf->nb_evenements_max = MAX(max, 1) ;
+}
+
+/*
+ * Divise les occurrences par 2 dès que leur total dépasse "seuil"
+ * (0 : jamais). Le codeur et le décodeur doivent avoir le même seuil.
+ */
+void shannon_fano_seuil(struct shannon_fano *sf, long seuil)
+{
+  sf->seuil = seuil ;
+}
+
+/*
+ * Active la reconstruction des codes tous les "periode" symboles
+ * (0 : codes recalculés à chaque symbole, c'est le mode normal).
+ * Le codeur et le décodeur doivent avoir la même période.
+ */
+void shannon_fano_periode(struct shannon_fano *sf, int periode)
+{
+  sf->periode = periode ;
+  if ( periode )
+    reconstruit_codes(sf) ;
 }
 
 /*
@@ -187,19 +937,23 @@ static void incremente_et_ordonne(struct shannon_fano *sf, int position)
 void put_entier_shannon_fano(struct bitstream *bs
 			     ,struct shannon_fano *sf, int evenement)
 {
+    if ( sf->periode )
+      {
+        put_entier_periodique(bs, sf, evenement);
+        return;
+      }
     int position = trouve_position(sf,evenement);
     //fprintf( stderr, "So bo vao: %d\n",evenement);
     //fprintf( stderr, "Trouve: %d\n",position);
     encode_position(bs,sf,position);
 
-    if (sf->evenements[position].valeur == VALEUR_ESCAPE){
-          sf->evenements[sf->nb_evenements].nb_occurrences = 1;
-          sf->evenements[sf->nb_evenements].valeur = evenement;
-          sf->nb_evenements++;
+    if (sf->valeurs[position] == VALEUR_ESCAPE){
+          ajoute_evenement(sf, evenement);
+          sf->nb_escapes++;
           put_bits(bs, sizeof(int)*8 ,evenement);
     }
           incremente_et_ordonne(sf, position);
-
+          vieillit(sf);
 }
 
 /*
@@ -234,14 +988,16 @@ static int decode_position(struct bitstream *bs,struct shannon_fano *sf)
 int get_entier_shannon_fano(struct bitstream *bs, struct shannon_fano *sf)
 {
     //fprintf( stderr, "====Lay so====\n");
+    if ( sf->periode )
+      return get_entier_periodique(bs, sf);
     int valeur = -1;
     int pos = -1;
     if(sf->nb_evenements == 1){
         valeur = get_bits(bs,sizeof(int)*8);
-        sf->nb_evenements++;
-        sf->evenements[0].nb_occurrences++;
-        sf->evenements[1].nb_occurrences = 1;
-        sf->evenements[1].valeur = valeur;
+        sf->nb_escapes++;
+        incremente_et_ordonne(sf, 0);
+        ajoute_evenement(sf, valeur);
+        vieillit(sf);
         //fprintf( stderr, "lay duoc so:%d\n",valeur);
         return valeur;
       }
@@ -250,19 +1006,19 @@ int get_entier_shannon_fano(struct bitstream *bs, struct shannon_fano *sf)
 
         pos = decode_position(bs,sf);
 
-          if(sf->evenements[pos].valeur == VALEUR_ESCAPE)
+          if(sf->valeurs[pos] == VALEUR_ESCAPE)
             {
               valeur = get_bits(bs,sizeof(int)*8);
-              sf->evenements[sf->nb_evenements].valeur = valeur;
-              sf->evenements[sf->nb_evenements].nb_occurrences = 1;
-              sf->nb_evenements++;
+              ajoute_evenement(sf, valeur);
+              sf->nb_escapes++;
             }
             else
             {
                 //fprintf( stderr, "Wrong case \n");
-                valeur = sf->evenements[pos].valeur;
+                valeur = sf->valeurs[pos];
             }
             incremente_et_ordonne(sf, pos);
+            vieillit(sf);
       }
 
 
@@ -272,6 +1028,15 @@ int get_entier_shannon_fano(struct bitstream *bs, struct shannon_fano *sf)
 
 }
 
+/*
+ * Nombre d'ESCAPE écrits ou lus depuis l'ouverture
+ * (les réinitialisations ne le remettent pas à 0).
+ */
+unsigned long nb_escapes_shannon_fano(const struct shannon_fano *sf)
+{
+  return sf->nb_escapes ;
+}
+
 /*
  * Fonctions pour les tests, NE PAS MODIFIER, NE PAS UTILISER.
  */
@@ -281,8 +1046,8 @@ int sf_get_nb_evenements(struct shannon_fano *sf)
  }
 void sf_get_evenement(struct shannon_fano *sf, int i, int *valeur, int *nb_occ)
  {
-   *valeur = sf->evenements[i].valeur ;
-   *nb_occ = sf->evenements[i].nb_occurrences ;
+   *valeur = sf->valeurs[i] ;
+   *nb_occ = sf->nb_occurrences[i] ;
  }
 int sf_table_ok(const struct shannon_fano *sf)
  {
@@ -292,12 +1057,12 @@ int sf_table_ok(const struct shannon_fano *sf)
   for(i=0;i<sf->nb_evenements;i++)
     {
     if ( i != 0
-        && sf->evenements[i-1].nb_occurrences<sf->evenements[i].nb_occurrences)
+        && sf->nb_occurrences[i-1]<sf->nb_occurrences[i])
 	{
 	   fprintf(stderr, "La table des événements n'est pas triée\n") ;
 	   return(0) ;
 	}
-    if ( sf->evenements[i].valeur == VALEUR_ESCAPE )
+    if ( sf->valeurs[i] == VALEUR_ESCAPE )
 	escape = 1 ;
     }
  if ( escape == 0 )
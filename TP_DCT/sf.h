@@ -12,8 +12,13 @@ struct shannon_fano ;
 struct shannon_fano* open_shannon_fano() ;
 
 void close_shannon_fano(struct shannon_fano *sf) ;
+void reinitialise_shannon_fano(struct shannon_fano *sf) ;
 void put_entier_shannon_fano(struct bitstream *bs, struct shannon_fano *sf, int evenement) ;
 int get_entier_shannon_fano(struct bitstream *bs, struct shannon_fano *sf) ;
+unsigned long nb_escapes_shannon_fano(const struct shannon_fano *sf) ;
+void shannon_fano_periode(struct shannon_fano *sf, int periode) ;
+void shannon_fano_nb_evenements_max(struct shannon_fano *sf, int max) ;
+void shannon_fano_seuil(struct shannon_fano *sf, long seuil) ;
 
 /* Pour les tests */
 
@@ -2,6 +2,7 @@
 #include "sf.h"
 #include "exception.h"
 #include "bits.h"
+#include "intstream.h"
 
 void open_shannon_fano_tst()
 {
@@ -51,6 +52,92 @@ void close_shannon_fano_tst()
 */
 }
 
+void reinitialise_shannon_fano_tst()
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  int i, valeur, nb_occ ;
+
+  sf = open_shannon_fano() ;
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  for(i=0; i<100; i++)
+    put_entier_shannon_fano(bs, sf, i % 7) ;
+  reinitialise_shannon_fano(sf) ;
+  if ( sf_get_nb_evenements(sf) != 1 )
+    {
+      eprintf("Après réinitialisation, il doit rester un seul événement\n") ;
+      return ;
+    }
+  sf_get_evenement(sf, 0, &valeur, &nb_occ) ;
+  if ( valeur != 0x7fffffff || nb_occ != 1 )
+    {
+      eprintf("Après réinitialisation, ESCAPE doit avoir une occurrence\n") ;
+      return ;
+    }
+  /* Les anciennes valeurs ne doivent plus être trouvées */
+  nb_occ = nb_escapes_shannon_fano(sf) ;
+  for(i=0; i<100; i++)
+    put_entier_shannon_fano(bs, sf, i % 7) ;
+  if ( nb_escapes_shannon_fano(sf) != nb_occ + 7 || !sf_table_ok(sf) )
+    {
+      eprintf("Après réinitialisation, les valeurs sont à rajouter\n") ;
+      return ;
+    }
+  free(close_bitstream_memory(bs, NULL)) ;
+  close_shannon_fano(sf) ;
+}
+
+/*
+ * Chaque nouvelle valeur coûte un ESCAPE, les répétitions non.
+ * On vérifie aussi le décompte fait par l'intstream au-dessus.
+ */
+
+void nb_escapes_shannon_fano_tst()
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  struct intstream *is ;
+  char ligne[200] ;
+  FILE *json ;
+  int i ;
+
+  sf = open_shannon_fano() ;
+  if ( nb_escapes_shannon_fano(sf) != 0 )
+    {
+      eprintf("Pas d'ESCAPE avant le premier symbole\n") ;
+      return ;
+    }
+  json = tmpfile() ;
+  bs = open_bitstream_memory(NULL, 0, "w") ;
+  is = open_intstream(bs, Shannon_fano, sf) ;
+  intstream_statistiques(is, json, "essai") ;
+  for(i=0; i<10; i++)
+    put_entier_intstream(is, i % 3) ;
+  if ( nb_escapes_shannon_fano(sf) != 3 )
+    {
+      eprintf("3 valeurs différentes doivent coûter 3 ESCAPE, pas %lu\n"
+	      , nb_escapes_shannon_fano(sf)) ;
+      return ;
+    }
+  close_intstream(is) ;
+  rewind(json) ;
+  if ( fgets(ligne, sizeof(ligne), json) == NULL
+       || strncmp(ligne, "{\"intstream\": \"essai\""
+		  ", \"codage\": \"shannon_fano\""
+		  ", \"symboles\": 10, \"bits\": "
+		  , strlen("{\"intstream\": \"essai\""
+			   ", \"codage\": \"shannon_fano\""
+			   ", \"symboles\": 10, \"bits\": "))
+       || strstr(ligne, "\"escapes\": 3, \"longueurs\": [") == NULL )
+    {
+      eprintf("Mauvaises statistiques : %s\n", ligne) ;
+      return ;
+    }
+  fclose(json) ;
+  free(close_bitstream_memory(bs, NULL)) ;
+  close_shannon_fano(sf) ;
+}
+
 void put_entier_shannon_fano_tst()
 {
   struct shannon_fano *sf ;
@@ -285,3 +372,217 @@ void get_entier_shannon_fano_tst()
       close_shannon_fano(sf) ;
     }
 }
+
+/*
+ * Avec une période de 1 le flot doit être celui du mode normal,
+ * avec les autres périodes on doit relire ce qu'on a écrit
+ * (dans les deux ordres de bits, avec plus de 1024 valeurs différentes).
+ */
+
+static int valeur_periode(int i)
+{
+  return i % 3 ? (i * 7) % 23 - 11 : (i * 2654435761u) % 3000 ;
+}
+
+static unsigned char *ecrit_periode(int periode, const char *mode
+				    , size_t *taille)
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  int i ;
+
+  sf = open_shannon_fano() ;
+  if ( periode >= 0 )
+    shannon_fano_periode(sf, periode) ;
+  bs = open_bitstream_memory(NULL, 0, mode) ;
+  for(i=0; i<20000; i++)
+    put_entier_shannon_fano(bs, sf, valeur_periode(i)) ;
+  zone = close_bitstream_memory(bs, taille) ;
+  close_shannon_fano(sf) ;
+  return zone ;
+}
+
+void shannon_fano_periode_tst()
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  unsigned char *normal, *periodique ;
+  size_t taille_normal, taille_periodique ;
+  int periodes[] = { 1, 7, 1000 } ;
+  char *modes[] = { "w", "wl" } ;
+  int i, m, p, v ;
+
+  for(m=0; m < TAILLE(modes); m++)
+    {
+      normal = ecrit_periode(-1, modes[m], &taille_normal) ;
+      for(p=0; p < TAILLE(periodes); p++)
+	{
+	  periodique = ecrit_periode(periodes[p], modes[m]
+				     , &taille_periodique) ;
+	  if ( periodes[p] == 1
+	       && ( taille_periodique != taille_normal
+		    || memcmp(normal, periodique, taille_normal) ) )
+	    {
+	      eprintf("Avec une période de 1 le flot (%s) doit être"
+		      " celui du mode normal\n", modes[m]) ;
+	      return ;
+	    }
+	  sf = open_shannon_fano() ;
+	  shannon_fano_periode(sf, periodes[p]) ;
+	  bs = open_bitstream_memory(periodique, taille_periodique
+				     , m ? "rl" : "r") ;
+	  for(i=0; i<20000; i++)
+	    {
+	      v = get_entier_shannon_fano(bs, sf) ;
+	      if ( v != valeur_periode(i) )
+		{
+		  eprintf("Période %d (%s), symbole %d :"
+			  " j'attend %d et je reçois %d\n"
+			  , periodes[p], modes[m], i, valeur_periode(i), v) ;
+		  return ;
+		}
+	    }
+	  close_bitstream_memory(bs, NULL) ;
+	  close_shannon_fano(sf) ;
+	  free(periodique) ;
+	}
+      free(normal) ;
+    }
+}
+
+/*
+ * Au-delà de la limite les nouvelles valeurs restent des ESCAPE
+ * (et la relecture marche), sans limite la table dépasse
+ * les 200000 événements de l'ancienne version.
+ */
+
+void shannon_fano_nb_evenements_max_tst()
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille ;
+  int i, max, nb ;
+  int limites[] = { 0, 3, 1000 } ;
+
+  for(max=0; max < TAILLE(limites); max++)
+    {
+      nb = limites[max] ? 5000 : 250000 ;
+      sf = open_shannon_fano() ;
+      if ( limites[max] )
+	shannon_fano_nb_evenements_max(sf, limites[max]) ;
+      bs = open_bitstream_memory(NULL, 0, "w") ;
+      for(i=0; i<nb; i++)
+	put_entier_shannon_fano(bs, sf, i % 2 ? i : -(i % 7)) ;
+      if ( limites[max]
+	   ? sf_get_nb_evenements(sf) != limites[max]
+	   : sf_get_nb_evenements(sf) != nb / 2 + 8 )
+	{
+	  eprintf("Limite %d : %d événements dans la table\n"
+		  , limites[max], sf_get_nb_evenements(sf)) ;
+	  return ;
+	}
+      if ( limites[max] == 3 && nb_escapes_shannon_fano(sf) <= nb / 2 + 6 )
+	{
+	  eprintf("Limite %d : les valeurs hors table sont des ESCAPE\n"
+		  , limites[max]) ;
+	  return ;
+	}
+      zone = close_bitstream_memory(bs, &taille) ;
+      close_shannon_fano(sf) ;
+
+      sf = open_shannon_fano() ;
+      if ( limites[max] )
+	shannon_fano_nb_evenements_max(sf, limites[max]) ;
+      bs = open_bitstream_memory(zone, taille, "r") ;
+      for(i=0; i<nb; i++)
+	if ( get_entier_shannon_fano(bs, sf) != (i % 2 ? i : -(i % 7)) )
+	  {
+	    eprintf("Limite %d : mauvaise relecture du symbole %d\n"
+		    , limites[max], i) ;
+	    return ;
+	  }
+      if ( !sf_table_ok(sf) )
+	return ;
+      close_bitstream_memory(bs, NULL) ;
+      close_shannon_fano(sf) ;
+      free(zone) ;
+    }
+}
+
+/*
+ * Une source qui change de valeurs à mi-parcours :
+ * avec le vieillissement la table s'adapte plus vite
+ * et le flot est plus court. La relecture doit marcher
+ * (y compris avec les codes reconstruits périodiquement).
+ */
+
+static int valeur_seuil(int i)
+{
+  return i < 10000 ? i % 5 : 100 + (i * 7) % 11 ;
+}
+
+void shannon_fano_seuil_tst()
+{
+  struct shannon_fano *sf ;
+  struct bitstream *bs ;
+  unsigned char *zone ;
+  size_t taille, taille_sans ;
+  int i, essai, v, occ ;
+  long total ;
+  long seuils[] = { 0, 1000, 1000, 3 } ;
+  int periodes[] = { 0, 0, 100, 0 } ;
+
+  taille_sans = 0 ;
+  for(essai=0; essai < TAILLE(seuils); essai++)
+    {
+      sf = open_shannon_fano() ;
+      shannon_fano_seuil(sf, seuils[essai]) ;
+      if ( periodes[essai] )
+	shannon_fano_periode(sf, periodes[essai]) ;
+      bs = open_bitstream_memory(NULL, 0, "w") ;
+      for(i=0; i<20000; i++)
+	put_entier_shannon_fano(bs, sf, valeur_seuil(i)) ;
+      total = 0 ;
+      for(i=0; i<sf_get_nb_evenements(sf); i++)
+	{
+	  sf_get_evenement(sf, i, &v, &occ) ;
+	  total += occ ;
+	}
+      if ( seuils[essai] && total > MAX(seuils[essai], 2*i) )
+	{
+	  eprintf("Seuil %ld : le total des occurrences est %ld\n"
+		  , seuils[essai], total) ;
+	  return ;
+	}
+      if ( !sf_table_ok(sf) )
+	return ;
+      zone = close_bitstream_memory(bs, &taille) ;
+      close_shannon_fano(sf) ;
+      if ( essai == 0 )
+	taille_sans = taille ;
+      else if ( essai == 1 && taille >= taille_sans )
+	{
+	  eprintf("Le vieillissement doit aider : %lu octets au lieu de %lu\n"
+		  , (unsigned long)taille, (unsigned long)taille_sans) ;
+	  return ;
+	}
+
+      sf = open_shannon_fano() ;
+      shannon_fano_seuil(sf, seuils[essai]) ;
+      if ( periodes[essai] )
+	shannon_fano_periode(sf, periodes[essai]) ;
+      bs = open_bitstream_memory(zone, taille, "r") ;
+      for(i=0; i<20000; i++)
+	if ( get_entier_shannon_fano(bs, sf) != valeur_seuil(i) )
+	  {
+	    eprintf("Seuil %ld, période %d : mauvaise relecture"
+		    " du symbole %d\n", seuils[essai], periodes[essai], i) ;
+	    return ;
+	  }
+      close_bitstream_memory(bs, NULL) ;
+      close_shannon_fano(sf) ;
+      free(zone) ;
+    }
+}
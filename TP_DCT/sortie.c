@@ -0,0 +1,230 @@
+/*
+ * Ecriture groupée sur la sortie standard (voir "sortie.h").
+ *
+ * "vmsplice" met dans le tube les pages du tampon et non une copie :
+ * le tampon ne doit pas être modifié tant que le lecteur ne les a pas
+ * consommées. Le tube ne contient pas plus que sa capacité,
+ * donc quand on a donné derrière un tampon au moins une capacité
+ * d'octets, il a été lu. On utilise donc une file circulaire de
+ * NB_TAMPONS_TUBE tampons et on ne donne que des tampons pleins :
+ * un tampon est réutilisé quand les NB_TAMPONS_TUBE-1 suivants
+ * sont passés.
+ *
+ * Le lecteur peut agrandir le tube à tout moment ("F_SETPIPE_SZ"),
+ * la capacité est donc relue avant chaque réutilisation
+ * (voir "tampon_peut_etre_dans_le_tube").
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "bases.h"
+#include "sortie.h"
+
+#define TAILLE_TAMPON_SORTIE (256*1024)	/* Si ce n'est pas un tube */
+#define TAILLE_TUBE          (1024*1024)	/* Capacité demandée au noyau */
+/*
+ * Invariant : un tampon n'est réutilisé que si la capacité du tube
+ * est au plus (NB_TAMPONS_TUBE-1) tampons, sinon on passe à "writev".
+ */
+#define NB_TAMPONS_TUBE      4
+
+static struct
+{
+  int            initialise ;
+  int            tube ;		     /* On utilise "vmsplice" */
+  int            nb_vmsplice ;	     /* Nombre de "vmsplice" réussis */
+  size_t         taille ;	     /* Taille d'un tampon */
+  unsigned char *tampons[NB_TAMPONS_TUBE] ;
+  int            courant ;
+  size_t         nb ;		     /* Octets en attente dans "courant" */
+} sortie ;
+
+/*
+ * Dernier recours si le filtre n'a pas appelé "sortie_vide" :
+ * on est dans "exit", on ne peut que prévenir et changer le code retour.
+ */
+
+static void fin(void)
+{
+  if ( sortie_vide() )
+    {
+      perror("sortie_vide") ;
+      _exit(1) ;
+    }
+}
+
+static void alloue_tampon(unsigned char **tampon)
+{
+  if ( posix_memalign((void**)tampon, sysconf(_SC_PAGESIZE), sortie.taille) )
+    {
+      fprintf(stderr, "Plus de memoire\n") ;
+      EXIT ;
+    }
+}
+
+static void initialise(void)
+{
+  struct stat st ;
+  int i, taille ;
+
+  sortie.initialise = 1 ;
+  sortie.tube = 0 ;
+  sortie.taille = TAILLE_TAMPON_SORTIE ;
+#ifdef F_GETPIPE_SZ
+  if ( fstat(1, &st) == 0 && S_ISFIFO(st.st_mode) )
+    {
+      fcntl(1, F_SETPIPE_SZ, TAILLE_TUBE) ; /* Echoue si pas le droit */
+      taille = fcntl(1, F_GETPIPE_SZ) ;
+      if ( taille > 0 )
+	{
+	  sortie.tube = 1 ;
+	  sortie.taille = taille ;
+	}
+    }
+#endif
+  for(i=0; i < (sortie.tube ? NB_TAMPONS_TUBE : 1); i++)
+    alloue_tampon(&sortie.tampons[i]) ;
+  atexit(fin) ;
+}
+
+/*
+ * Envoie complètement les "n" morceaux de "v" (qui est modifié),
+ * même si le noyau n'en prend qu'une partie.
+ * Si le premier "vmsplice" est refusé, on continue avec "writev".
+ */
+
+static int envoie(struct iovec *v, int n, int tube)
+{
+  ssize_t r ;
+
+  if ( fflush(stdout) )		/* Ce qui a été écrit avant par stdio */
+    return -1 ;
+  while( n )
+    {
+      r = tube ? vmsplice(1, v, n, 0) : writev(1, v, n) ;
+      if ( r < 0 )
+	{
+	  if ( errno == EINTR )
+	    continue ;
+	  if ( tube && sortie.nb_vmsplice == 0 )
+	    {
+	      sortie.tube = tube = 0 ;
+	      continue ;
+	    }
+	  return -1 ;
+	}
+      if ( tube )
+	sortie.nb_vmsplice++ ;
+      for( ; n && (size_t)r >= v->iov_len ; n--, v++)
+	r -= v->iov_len ;
+      if ( n )
+	{
+	  v->iov_base = (char*)v->iov_base + r ;
+	  v->iov_len -= r ;
+	}
+    }
+  return 0 ;
+}
+
+/*
+ * Le contenu du tube est au plus sa capacité actuelle (le noyau refuse
+ * de la réduire en dessous du contenu) et les NB_TAMPONS_TUBE-1 tampons
+ * donnés après le tampon suivant sont les plus récents.
+ * Si ils remplissent la capacité, le tampon suivant a été lu.
+ */
+
+static int tampon_peut_etre_dans_le_tube(void)
+{
+#ifdef F_GETPIPE_SZ
+  int capacite ;
+
+  capacite = fcntl(1, F_GETPIPE_SZ) ;
+  return capacite < 0
+    || (size_t)capacite > (NB_TAMPONS_TUBE - 1) * sortie.taille ;
+#else
+  return 1 ;
+#endif
+}
+
+/*
+ * Le tampon courant est plein : on le donne et on passe au suivant.
+ * Si le tube a été agrandi, le suivant est peut-être encore dans
+ * le tube : on l'abandonne (sans le libérer) pour un tampon neuf
+ * et on continue avec "writev", qui copie.
+ */
+
+static int envoie_tampon(void)
+{
+  struct iovec v ;
+  int tube ;
+
+  v.iov_base = sortie.tampons[sortie.courant] ;
+  v.iov_len = sortie.nb ;
+  sortie.nb = 0 ;
+  tube = sortie.tube ;
+  if ( envoie(&v, 1, tube) )
+    return -1 ;
+  if ( tube )
+    {
+      sortie.courant = (sortie.courant + 1) % NB_TAMPONS_TUBE ;
+      if ( tampon_peut_etre_dans_le_tube() )
+	{
+	  alloue_tampon(&sortie.tampons[sortie.courant]) ;
+	  sortie.tube = 0 ;
+	}
+    }
+  return 0 ;
+}
+
+int sortie_ecrit(const void *octets, size_t nb)
+{
+  const unsigned char *o = octets ;
+  struct iovec v[2] ;
+  size_t n ;
+
+  if ( !sortie.initialise )
+    initialise() ;
+
+  if ( !sortie.tube && nb >= sortie.taille / 2 )
+    {
+      /* Gros bloc : un seul appel système et pas de recopie */
+      v[0].iov_base = sortie.tampons[sortie.courant] ;
+      v[0].iov_len = sortie.nb ;
+      v[1].iov_base = (void*)octets ;
+      v[1].iov_len = nb ;
+      sortie.nb = 0 ;
+      return envoie(v, 2, 0) ;
+    }
+
+  while( nb )
+    {
+      n = MIN(nb, sortie.taille - sortie.nb) ;
+      memcpy(sortie.tampons[sortie.courant] + sortie.nb, o, n) ;
+      sortie.nb += n ;
+      o += n ;
+      nb -= n ;
+      if ( sortie.nb == sortie.taille && envoie_tampon() )
+	return -1 ;
+    }
+  return 0 ;
+}
+
+/*
+ * Un tampon incomplet est copié (par "write") et non donné :
+ * on peut continuer à le remplir tout de suite.
+ */
+
+int sortie_vide(void)
+{
+  struct iovec v ;
+
+  if ( sortie.nb == 0 )
+    return 0 ;
+  v.iov_base = sortie.tampons[sortie.courant] ;
+  v.iov_len = sortie.nb ;
+  sortie.nb = 0 ;
+  return envoie(&v, 1, 0) ;
+}
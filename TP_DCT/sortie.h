@@ -0,0 +1,29 @@
+#ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_SORTIE_H
+#define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_SORTIE_H
+
+#include <stddef.h>
+
+/*
+ * Ecriture groupée sur la sortie standard pour les filtres
+ * enchaînés par des tubes.
+ *
+ * Les petites écritures sont regroupées dans de grands tampons.
+ * Si la sortie standard est un tube, les tampons pleins sont donnés
+ * au noyau par "vmsplice" (les pages passent dans le tube sans copie),
+ * sinon on écrit par "writev" les octets en attente et les grosses
+ * écritures de l'appelant, sans les recopier.
+ *
+ * Ce qui a été écrit avant par "stdio" sur "stdout" est envoyé
+ * en premier. Il ne faut pas écrire par "stdio" sur "stdout"
+ * après "sortie_ecrit" sans avoir appelé "sortie_vide".
+ * "sortie_vide" est appelée automatiquement par "exit", mais il faut
+ * l'appeler à la fin pour savoir si les dernières écritures ont réussi
+ * (à la sortie, un échec fait seulement retourner 1 au processus).
+ *
+ * Les fonctions retournent 0 si tout va bien, -1 si l'écriture a échoué.
+ */
+
+int sortie_ecrit(const void *octets, size_t nb) ;
+int sortie_vide(void) ;
+
+#endif
@@ -61,6 +61,10 @@ int main(int argc, char **argv)
 		 F(Exception_fichier_ecriture_dans_fichier_ouvert_en_lecture) ;
 		 F(Exception_fichier_lecture_dans_fichier_ouvert_en_ecriture) ;
 		 F(Exception_arbre_shannon_fano_invalide) ;
+		 F(Exception_marqueur_segment_invalide) ;
+		 F(Exception_fichier_positionnement) ;
+		 F(Exception_ordre_bits_invalide) ;
+		 F(Exception_somme_controle_invalide) ;
 		 ) ;
 	      exit(r) ;
 	    }
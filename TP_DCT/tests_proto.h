@@ -3,21 +3,61 @@ void nb_bits_utile_tst() ;
 void pow2_tst() ;
 void prend_bit_tst() ;
 void pose_bit_tst() ;
+void nb_zeros_gauche_tst() ;
+void nb_bits_utile_tableau_tst() ;
+void extrait_bits_tst() ;
+void depose_bits_tst() ;
 void open_bitstream_tst() ;
 void close_bitstream_tst() ;
+void open_bitstream_memory_tst() ;
+void close_bitstream_memory_tst() ;
+void open_bitstream_mmap_tst() ;
+void open_bitstream_asynchrone_tst() ;
 void put_bit_tst() ;
 void get_bit_tst() ;
+void bitstream_tell_bits_tst() ;
+void bitstream_align_tst() ;
+void bitstream_seek_bits_tst() ;
+void bitstream_statistiques_tst() ;
+void bitstream_crc_debut_tst() ;
+void bitstream_crc_fin_tst() ;
+void open_bitstream_sous_flot_tst() ;
+void bitstream_zone_tst() ;
+void bitstream_erreur_tst() ;
+void bitstream_signale_tst() ;
+void bitstream_lsb_tst() ;
 void put_bits_tst() ;
 void get_bits_tst() ;
+void peek_bits_tst() ;
+void skip_bits_tst() ;
+void put_bits_array_tst() ;
+void get_bits_array_tst() ;
 void put_bit_string_tst() ;
 void put_entier_tst() ;
 void get_entier_tst() ;
 void put_entier_signe_tst() ;
 void get_entier_signe_tst() ;
+void put_exp_golomb_tst() ;
+void get_exp_golomb_tst() ;
+void put_elias_gamma_tst() ;
+void get_elias_gamma_tst() ;
+void put_elias_delta_tst() ;
+void get_elias_delta_tst() ;
+void put_rice_tst() ;
+void get_rice_tst() ;
+void put_tableau_entier_signe_tst() ;
+void get_tableau_entier_signe_tst() ;
+void put_tableau_exp_golomb_signe_tst() ;
+void get_tableau_exp_golomb_signe_tst() ;
 void open_shannon_fano_tst() ;
 void close_shannon_fano_tst() ;
+void reinitialise_shannon_fano_tst() ;
 void put_entier_shannon_fano_tst() ;
 void get_entier_shannon_fano_tst() ;
+void nb_escapes_shannon_fano_tst() ;
+void shannon_fano_periode_tst() ;
+void shannon_fano_nb_evenements_max_tst() ;
+void shannon_fano_seuil_tst() ;
 void allocation_matrice_float_tst() ;
 void liberation_matrice_float_tst() ;
 void coef_dct_tst() ;
@@ -25,10 +65,19 @@ void dct_tst() ;
 void psycho_tst() ;
 void compresse_tst() ;
 void decompresse_tst() ;
+void put_debut_segment_tst() ;
+void put_debut_segment_crc_tst() ;
+void put_fin_segment_tst() ;
+void get_debut_segment_tst() ;
+void get_fin_segment_tst() ;
+void put_index_segments_tst() ;
+void get_index_segments_tst() ;
+void va_au_segment_tst() ;
 void lire_ligne_tst() ;
 void allocation_image_tst() ;
 void liberation_image_tst() ;
 void lecture_image_tst() ;
+void lecture_image_memoire_tst() ;
 void ecriture_image_tst() ;
 void dct_image_tst() ;
 void quantification_tst() ;
@@ -3,21 +3,61 @@
 { "pow2", pow2_tst },
 { "prend_bit", prend_bit_tst },
 { "pose_bit", pose_bit_tst },
+{ "nb_zeros_gauche", nb_zeros_gauche_tst },
+{ "nb_bits_utile_tableau", nb_bits_utile_tableau_tst },
+{ "extrait_bits", extrait_bits_tst },
+{ "depose_bits", depose_bits_tst },
 { "open_bitstream", open_bitstream_tst },
 { "close_bitstream", close_bitstream_tst },
+{ "open_bitstream_memory", open_bitstream_memory_tst },
+{ "close_bitstream_memory", close_bitstream_memory_tst },
+{ "open_bitstream_mmap", open_bitstream_mmap_tst },
+{ "open_bitstream_asynchrone", open_bitstream_asynchrone_tst },
 { "put_bit", put_bit_tst },
 { "get_bit", get_bit_tst },
+{ "bitstream_tell_bits", bitstream_tell_bits_tst },
+{ "bitstream_align", bitstream_align_tst },
+{ "bitstream_seek_bits", bitstream_seek_bits_tst },
+{ "bitstream_statistiques", bitstream_statistiques_tst },
+{ "bitstream_crc_debut", bitstream_crc_debut_tst },
+{ "bitstream_crc_fin", bitstream_crc_fin_tst },
+{ "open_bitstream_sous_flot", open_bitstream_sous_flot_tst },
+{ "bitstream_zone", bitstream_zone_tst },
+{ "bitstream_erreur", bitstream_erreur_tst },
+{ "bitstream_signale", bitstream_signale_tst },
+{ "bitstream_lsb", bitstream_lsb_tst },
 { "put_bits", put_bits_tst },
 { "get_bits", get_bits_tst },
+{ "peek_bits", peek_bits_tst },
+{ "skip_bits", skip_bits_tst },
+{ "put_bits_array", put_bits_array_tst },
+{ "get_bits_array", get_bits_array_tst },
 { "put_bit_string", put_bit_string_tst },
 { "put_entier", put_entier_tst },
 { "get_entier", get_entier_tst },
 { "put_entier_signe", put_entier_signe_tst },
 { "get_entier_signe", get_entier_signe_tst },
+{ "put_exp_golomb", put_exp_golomb_tst },
+{ "get_exp_golomb", get_exp_golomb_tst },
+{ "put_elias_gamma", put_elias_gamma_tst },
+{ "get_elias_gamma", get_elias_gamma_tst },
+{ "put_elias_delta", put_elias_delta_tst },
+{ "get_elias_delta", get_elias_delta_tst },
+{ "put_rice", put_rice_tst },
+{ "get_rice", get_rice_tst },
+{ "put_tableau_entier_signe", put_tableau_entier_signe_tst },
+{ "get_tableau_entier_signe", get_tableau_entier_signe_tst },
+{ "put_tableau_exp_golomb_signe", put_tableau_exp_golomb_signe_tst },
+{ "get_tableau_exp_golomb_signe", get_tableau_exp_golomb_signe_tst },
 { "open_shannon_fano", open_shannon_fano_tst },
 { "close_shannon_fano", close_shannon_fano_tst },
+{ "reinitialise_shannon_fano", reinitialise_shannon_fano_tst },
 { "put_entier_shannon_fano", put_entier_shannon_fano_tst },
 { "get_entier_shannon_fano", get_entier_shannon_fano_tst },
+{ "nb_escapes_shannon_fano", nb_escapes_shannon_fano_tst },
+{ "shannon_fano_periode", shannon_fano_periode_tst },
+{ "shannon_fano_nb_evenements_max", shannon_fano_nb_evenements_max_tst },
+{ "shannon_fano_seuil", shannon_fano_seuil_tst },
 { "allocation_matrice_float", allocation_matrice_float_tst },
 { "liberation_matrice_float", liberation_matrice_float_tst },
 { "coef_dct", coef_dct_tst },
@@ -25,10 +65,19 @@
 { "psycho", psycho_tst },
 { "compresse", compresse_tst },
 { "decompresse", decompresse_tst },
+{ "put_debut_segment", put_debut_segment_tst },
+{ "put_debut_segment_crc", put_debut_segment_crc_tst },
+{ "put_fin_segment", put_fin_segment_tst },
+{ "get_debut_segment", get_debut_segment_tst },
+{ "get_fin_segment", get_fin_segment_tst },
+{ "put_index_segments", put_index_segments_tst },
+{ "get_index_segments", get_index_segments_tst },
+{ "va_au_segment", va_au_segment_tst },
 { "lire_ligne", lire_ligne_tst },
 { "allocation_image", allocation_image_tst },
 { "liberation_image", liberation_image_tst },
 { "lecture_image", lecture_image_tst },
+{ "lecture_image_memoire", lecture_image_memoire_tst },
 { "ecriture_image", ecriture_image_tst },
 { "dct_image", dct_image_tst },
 { "quantification", quantification_tst },
@@ -0,0 +1,465 @@
+/*
+ * Conversions entre tableaux d'entiers et octets "poids fort en premier"
+ * (ou "poids faible en premier" pour les flots LSB).
+ *
+ * C'est le coeur de "put_bits_array" et "get_bits_array" quand
+ * le flot est sur une frontière d'octet et que la largeur est 8, 16 ou 32.
+ * Il y a aussi l'entrelacement des entiers signés pour le codage
+ * des tableaux d'entiers (voir "put_tableau_entier_signe").
+ *
+ * Il y a trois versions de chaque conversion :
+ *    - "base" : un octet à la fois, marche partout.
+ *    - "sse2" : 16 octets à la fois.
+ *    - "avx2" : 32 octets à la fois (avec "pshufb" pour les permutations).
+ * La meilleure version supportée par le processeur est choisie
+ * à la première utilisation. Le compilateur génère les versions SIMD
+ * grâce à l'attribut "target" : il n'y a pas d'option de compilation
+ * à ajouter et le programme tourne aussi sur un processeur sans AVX2.
+ */
+
+#include <pthread.h>
+#include "bases.h"
+#include "vecteur.h"
+
+#ifdef PROCESSEUR_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*Vers_octets)(unsigned char *, const unsigned int *
+			    , size_t, unsigned int, int) ;
+typedef void (*Vers_entiers)(unsigned int *, const unsigned char *
+			     , size_t, unsigned int, int) ;
+typedef void (*Entrelace)(unsigned int *, const int *, size_t) ;
+typedef void (*Desentrelace)(int *, const unsigned int *, size_t) ;
+
+static void vers_octets_base(unsigned char *o, const unsigned int *v
+			     , size_t n, unsigned int taille, int pb)
+{
+  size_t i ;
+  unsigned int j ;
+
+  for(i=0; i<n; i++)
+    for(j=0; j<taille; j++)
+      *o++ = v[i] >> (8 * (pb ? j : taille - 1 - j)) ;
+}
+
+static void vers_entiers_base(unsigned int *v, const unsigned char *o
+			      , size_t n, unsigned int taille, int pb)
+{
+  size_t i ;
+  unsigned int j ;
+
+  for(i=0; i<n; i++)
+    {
+      v[i] = 0 ;
+      for(j=0; j<taille; j++)
+	if ( pb )
+	  v[i] |= (unsigned int)*o++ << (8 * j) ;
+	else
+	  v[i] = (v[i] << 8) | *o++ ;
+    }
+}
+
+/*
+ * Entrelacement des entiers signés : 0 -1 1 -2 2 ... --> 0 1 2 3 4 ...
+ * C'est aussi 2 * magnitude + signe avec magnitude = -v-1 si v < 0.
+ */
+
+static void entrelace_base(unsigned int *u, const int *v, size_t n)
+{
+  size_t i ;
+
+  for(i=0; i<n; i++)
+    u[i] = (unsigned int)v[i] << 1 ^ (unsigned int)(v[i] >> 31) ;
+}
+
+static void desentrelace_base(int *v, const unsigned int *u, size_t n)
+{
+  size_t i ;
+
+  for(i=0; i<n; i++)
+    v[i] = (int)(u[i] >> 1 ^ -(u[i] & 1)) ;
+}
+
+#ifdef PROCESSEUR_X86
+
+#define CHARGE(P)    _mm_loadu_si128((const __m128i*)(P))
+#define RANGE(P, X)  _mm_storeu_si128((__m128i*)(P), X)
+#define CHARGE256(P) _mm256_loadu_si256((const __m256i*)(P))
+#define RANGE256(P, X) _mm256_storeu_si256((__m256i*)(P), X)
+
+/*
+ * Echange les deux octets de chaque mot de 16 bits
+ */
+__attribute__((target("sse2")))
+static inline __m128i echange16(__m128i x)
+{
+  return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)) ;
+}
+
+/*
+ * Inverse l'ordre des octets de chaque mot de 32 bits
+ */
+__attribute__((target("sse2")))
+static inline __m128i echange32(__m128i x)
+{
+  x = echange16(x) ;
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1) ;
+}
+
+/*
+ * Les 16 bits de droite de chaque entier, étendus avec leur signe
+ * pour que "packs" ne sature pas.
+ */
+__attribute__((target("sse2")))
+static inline __m128i tronque16(__m128i x)
+{
+  return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16) ;
+}
+
+__attribute__((target("sse2")))
+static void vers_octets_sse2(unsigned char *o, const unsigned int *v
+			     , size_t n, unsigned int taille, int pb)
+{
+  const __m128i masque = _mm_set1_epi32(0xFF) ;
+  __m128i a, b ;
+  size_t i ;
+
+  i = 0 ;
+  switch(taille)
+    {
+    case 1:
+      for( ; i + 16 <= n ; i += 16)
+	{
+	  a = _mm_packs_epi32(_mm_and_si128(CHARGE(v+i   ), masque)
+			      , _mm_and_si128(CHARGE(v+i+ 4), masque)) ;
+	  b = _mm_packs_epi32(_mm_and_si128(CHARGE(v+i+ 8), masque)
+			      , _mm_and_si128(CHARGE(v+i+12), masque)) ;
+	  RANGE(o + i, _mm_packus_epi16(a, b)) ;
+	}
+      break ;
+    case 2:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  a = _mm_packs_epi32(tronque16(CHARGE(v+i)), tronque16(CHARGE(v+i+4)));
+	  RANGE(o + 2*i, pb ? a : echange16(a)) ;
+	}
+      break ;
+    case 4:
+      for( ; i + 4 <= n ; i += 4)
+	RANGE(o + 4*i, pb ? CHARGE(v+i) : echange32(CHARGE(v+i))) ;
+      break ;
+    }
+  vers_octets_base(o + taille*i, v + i, n - i, taille, pb) ;
+}
+
+__attribute__((target("sse2")))
+static void vers_entiers_sse2(unsigned int *v, const unsigned char *o
+			      , size_t n, unsigned int taille, int pb)
+{
+  const __m128i zero = _mm_setzero_si128() ;
+  __m128i x, a ;
+  size_t i ;
+
+  i = 0 ;
+  switch(taille)
+    {
+    case 1:
+      for( ; i + 16 <= n ; i += 16)
+	{
+	  x = CHARGE(o + i) ;
+	  a = _mm_unpacklo_epi8(x, zero) ;
+	  RANGE(v+i   , _mm_unpacklo_epi16(a, zero)) ;
+	  RANGE(v+i+ 4, _mm_unpackhi_epi16(a, zero)) ;
+	  a = _mm_unpackhi_epi8(x, zero) ;
+	  RANGE(v+i+ 8, _mm_unpacklo_epi16(a, zero)) ;
+	  RANGE(v+i+12, _mm_unpackhi_epi16(a, zero)) ;
+	}
+      break ;
+    case 2:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  x = CHARGE(o + 2*i) ;
+	  if ( ! pb )
+	    x = echange16(x) ;
+	  RANGE(v+i  , _mm_unpacklo_epi16(x, zero)) ;
+	  RANGE(v+i+4, _mm_unpackhi_epi16(x, zero)) ;
+	}
+      break ;
+    case 4:
+      for( ; i + 4 <= n ; i += 4)
+	RANGE(v+i, pb ? CHARGE(o + 4*i) : echange32(CHARGE(o + 4*i))) ;
+      break ;
+    }
+  vers_entiers_base(v + i, o + taille*i, n - i, taille, pb) ;
+}
+
+/*
+ * Pour AVX2 les permutations d'octets se font dans chaque moitié
+ * de 128 bits avec "pshufb" (-1 met l'octet à 0),
+ * puis on rassemble les deux moitiés.
+ */
+
+#define MASQUE_256(A,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P)			\
+  _mm256_setr_epi8(A,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P			\
+		   ,A,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P)
+
+__attribute__((target("avx2")))
+static void vers_octets_avx2(unsigned char *o, const unsigned int *v
+			     , size_t n, unsigned int taille, int pb)
+{
+  const __m256i masque16 = pb
+    ? MASQUE_256(0,1,4,5,8,9,12,13,-1,-1,-1,-1,-1,-1,-1,-1)
+    : MASQUE_256(1,0,5,4,9,8,13,12,-1,-1,-1,-1,-1,-1,-1,-1) ;
+  __m256i x ;
+  size_t i ;
+
+  i = 0 ;
+  switch(taille)
+    {
+    case 1:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  x = _mm256_shuffle_epi8(CHARGE256(v+i)
+				  , MASQUE_256(0,4,8,12,-1,-1,-1,-1
+					       ,-1,-1,-1,-1,-1,-1,-1,-1)) ;
+	  x = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0,4,1,1
+							       ,1,1,1,1)) ;
+	  _mm_storel_epi64((__m128i*)(o + i), _mm256_castsi256_si128(x)) ;
+	}
+      break ;
+    case 2:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  x = _mm256_shuffle_epi8(CHARGE256(v+i), masque16) ;
+	  x = _mm256_permute4x64_epi64(x, 0x08) ;
+	  RANGE(o + 2*i, _mm256_castsi256_si128(x)) ;
+	}
+      break ;
+    case 4:
+      if ( pb )
+	break ;			/* Simple copie, faite par "memcpy" */
+      for( ; i + 8 <= n ; i += 8)
+	RANGE256(o + 4*i
+		 , _mm256_shuffle_epi8(CHARGE256(v+i)
+				       , MASQUE_256(3,2,1,0,7,6,5,4
+						    ,11,10,9,8,15,14,13,12)));
+      break ;
+    }
+  vers_octets_base(o + taille*i, v + i, n - i, taille, pb) ;
+}
+
+__attribute__((target("avx2")))
+static void vers_entiers_avx2(unsigned int *v, const unsigned char *o
+			      , size_t n, unsigned int taille, int pb)
+{
+  __m128i x ;
+  size_t i ;
+
+  i = 0 ;
+  switch(taille)
+    {
+    case 1:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  x = _mm_loadl_epi64((const __m128i*)(o + i)) ;
+	  RANGE256(v+i, _mm256_cvtepu8_epi32(x)) ;
+	}
+      break ;
+    case 2:
+      for( ; i + 8 <= n ; i += 8)
+	{
+	  x = CHARGE(o + 2*i) ;
+	  if ( ! pb )
+	    x = _mm_shuffle_epi8(x, _mm_setr_epi8(1,0,3,2,5,4,7,6
+						  ,9,8,11,10,13,12,15,14)) ;
+	  RANGE256(v+i, _mm256_cvtepu16_epi32(x)) ;
+	}
+      break ;
+    case 4:
+      if ( pb )
+	break ;
+      for( ; i + 8 <= n ; i += 8)
+	RANGE256(v+i
+		 , _mm256_shuffle_epi8(CHARGE256(o + 4*i)
+				       , MASQUE_256(3,2,1,0,7,6,5,4
+						    ,11,10,9,8,15,14,13,12)));
+      break ;
+    }
+  vers_entiers_base(v + i, o + taille*i, n - i, taille, pb) ;
+}
+
+__attribute__((target("sse2")))
+static void entrelace_sse2(unsigned int *u, const int *v, size_t n)
+{
+  __m128i x ;
+  size_t i ;
+
+  for(i=0 ; i + 4 <= n ; i += 4)
+    {
+      x = CHARGE(v + i) ;
+      RANGE(u + i, _mm_xor_si128(_mm_slli_epi32(x, 1), _mm_srai_epi32(x, 31)));
+    }
+  entrelace_base(u + i, v + i, n - i) ;
+}
+
+__attribute__((target("sse2")))
+static void desentrelace_sse2(int *v, const unsigned int *u, size_t n)
+{
+  const __m128i un = _mm_set1_epi32(1) ;
+  __m128i x ;
+  size_t i ;
+
+  for(i=0 ; i + 4 <= n ; i += 4)
+    {
+      x = CHARGE(u + i) ;
+      RANGE(v + i, _mm_xor_si128(_mm_srli_epi32(x, 1)
+				 , _mm_sub_epi32(_mm_setzero_si128()
+						 , _mm_and_si128(x, un)))) ;
+    }
+  desentrelace_base(v + i, u + i, n - i) ;
+}
+
+__attribute__((target("avx2")))
+static void entrelace_avx2(unsigned int *u, const int *v, size_t n)
+{
+  __m256i x ;
+  size_t i ;
+
+  for(i=0 ; i + 8 <= n ; i += 8)
+    {
+      x = CHARGE256(v + i) ;
+      RANGE256(u + i, _mm256_xor_si256(_mm256_slli_epi32(x, 1)
+				       , _mm256_srai_epi32(x, 31))) ;
+    }
+  entrelace_base(u + i, v + i, n - i) ;
+}
+
+__attribute__((target("avx2")))
+static void desentrelace_avx2(int *v, const unsigned int *u, size_t n)
+{
+  const __m256i un = _mm256_set1_epi32(1) ;
+  __m256i x ;
+  size_t i ;
+
+  for(i=0 ; i + 8 <= n ; i += 8)
+    {
+      x = CHARGE256(u + i) ;
+      RANGE256(v + i, _mm256_xor_si256(_mm256_srli_epi32(x, 1)
+				       , _mm256_sub_epi32(_mm256_setzero_si256()
+							  , _mm256_and_si256(x, un))));
+    }
+  desentrelace_base(v + i, u + i, n - i) ;
+}
+
+#endif
+
+/*
+ * Choix de la version
+ */
+
+static Vers_octets  vers_octets ;
+static Vers_entiers vers_entiers ;
+static Entrelace    entrelace ;
+static Desentrelace desentrelace ;
+static pthread_once_t version_choisie = PTHREAD_ONCE_INIT ;
+
+static int choisit(const char *nom)
+{
+#ifdef PROCESSEUR_X86
+  __builtin_cpu_init() ;
+  if ( (nom == NULL || strcmp(nom, "avx2") == 0)
+       && __builtin_cpu_supports("avx2") )
+    {
+      vers_octets = vers_octets_avx2 ;
+      vers_entiers = vers_entiers_avx2 ;
+      entrelace = entrelace_avx2 ;
+      desentrelace = desentrelace_avx2 ;
+      return 1 ;
+    }
+  if ( (nom == NULL || strcmp(nom, "sse2") == 0)
+       && __builtin_cpu_supports("sse2") )
+    {
+      vers_octets = vers_octets_sse2 ;
+      vers_entiers = vers_entiers_sse2 ;
+      entrelace = entrelace_sse2 ;
+      desentrelace = desentrelace_sse2 ;
+      return 1 ;
+    }
+#endif
+  if ( nom == NULL || strcmp(nom, "base") == 0 )
+    {
+      vers_octets = vers_octets_base ;
+      vers_entiers = vers_entiers_base ;
+      entrelace = entrelace_base ;
+      desentrelace = desentrelace_base ;
+      return 1 ;
+    }
+  return 0 ;
+}
+
+static void choisit_meilleure(void)
+{
+  choisit(NULL) ;
+}
+
+/*
+ * Force une version ("base", "sse2" ou "avx2"), NULL pour la meilleure.
+ * Retourne 0 si le processeur ne sait pas faire (rien ne change).
+ * Sans appel, la meilleure est choisie une seule fois
+ * à la première utilisation, même par plusieurs fils d'exécution.
+ *
+ * Pour les tests seulement : le pointeur change sans synchronisation,
+ * pas d'appel pendant que d'autres fils utilisent ces fonctions.
+ */
+
+int vecteur_force(const char *nom)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  return choisit(nom) ;
+}
+
+/*
+ * Sur une machine petit boutiste, 32 bits poids faible en premier
+ * c'est la représentation en mémoire : une copie suffit.
+ */
+
+void entiers_vers_octets(unsigned char *octets, const unsigned int *v
+			 , size_t n, unsigned int taille, int petit_boutiste)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if ( petit_boutiste && taille == sizeof(*v) )
+    {
+      memcpy(octets, v, n * taille) ;
+      return ;
+    }
+#endif
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  (*vers_octets)(octets, v, n, taille, petit_boutiste) ;
+}
+
+void octets_vers_entiers(unsigned int *v, const unsigned char *octets
+			 , size_t n, unsigned int taille, int petit_boutiste)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if ( petit_boutiste && taille == sizeof(*v) )
+    {
+      memcpy(v, octets, n * taille) ;
+      return ;
+    }
+#endif
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  (*vers_entiers)(v, octets, n, taille, petit_boutiste) ;
+}
+
+void entrelace_signes(unsigned int *u, const int *v, size_t n)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  (*entrelace)(u, v, n) ;
+}
+
+void desentrelace_signes(int *v, const unsigned int *u, size_t n)
+{
+  pthread_once(&version_choisie, choisit_meilleure) ;
+  (*desentrelace)(v, u, n) ;
+}
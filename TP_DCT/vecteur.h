@@ -0,0 +1,29 @@
+#ifndef _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_VECTEUR_H
+#define _HOME_EXCO_REDACTEX_COURS_TRANS_COMP_IMAGE_TP_DCT2_VECTEUR_H
+
+#include <stddef.h>
+
+/*
+ * Conversion d'un tableau d'entiers en octets (et inversement)
+ * Chaque entier occupe "taille" octets (1, 2 ou 4), poids fort en premier,
+ * c'est l'ordre des bits dans un "bitstream".
+ * Si "petit_boutiste" est vrai, c'est le poids faible en premier
+ * (flot en mode LSB).
+ * Seuls les "8*taille" bits de droite des entiers sont rangés.
+ *
+ * Sur x86 les conversions utilisent SSE2 ou AVX2 suivant
+ * ce que le processeur sait faire (choisi à la première utilisation).
+ */
+
+void entiers_vers_octets(unsigned char *octets, const unsigned int *v, size_t n, unsigned int taille, int petit_boutiste) ;
+void octets_vers_entiers(unsigned int *v, const unsigned char *octets, size_t n, unsigned int taille, int petit_boutiste) ;
+/*
+ * Entrelacement des entiers signés pour les rendre positifs :
+ *    0 -1 1 -2 2 ... --> 0 1 2 3 4 ...
+ * (le bit de droite est le signe, les autres la magnitude)
+ */
+void entrelace_signes(unsigned int *u, const int *v, size_t n) ;
+void desentrelace_signes(int *v, const unsigned int *u, size_t n) ;
+int  vecteur_force(const char *nom) ;
+
+#endif